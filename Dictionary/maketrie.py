@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 Lyndon Hill
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Build the dictionary read by TVKTrie from a word list. Each line of the list
+# is a word and its frequency separated by a tab, lines starting with # are
+# ignored. Run from this directory after changing the list:
+#
+#   python3 maketrie.py thai-words.txt thai.trie
+#
+# The layout of the file is described in TVKTrie.cc
+
+import struct
+import sys
+
+class Node:
+    def __init__(self):
+        self.frequency = 0
+        self.best = 0
+        self.children = {}
+
+def read_words(name):
+    words = {}
+    with open(name, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+
+            fields = line.split("\t")
+            if len(fields) != 2:
+                sys.exit("%s:%d: expected a word and a frequency" % (name, number))
+
+            word, frequency = fields[0], int(fields[1])
+            if frequency < 1 or frequency > 0xffffffff:
+                sys.exit("%s:%d: frequency out of range" % (name, number))
+
+            # A word listed twice keeps the higher frequency
+            words[word] = max(words.get(word, 0), frequency)
+
+    return words
+
+def build(words):
+    root = Node()
+    for word, frequency in words.items():
+        # Labels are UTF-16 code units, the same as QChar
+        encoded = word.encode("utf-16-le")
+        units = struct.unpack("<%dH" % (len(encoded) // 2), encoded)
+
+        node = root
+        for unit in units:
+            node = node.children.setdefault(unit, Node())
+        node.frequency = frequency
+
+    def best(node):
+        node.best = max([node.frequency] + [best(c) for c in node.children.values()])
+        return node.best
+
+    best(root)
+    return root
+
+def write(root, count):
+    out = bytearray(16)
+
+    # Children are written before their parent so their offsets are known
+    def emit(node):
+        offsets = [(label, emit(child)) for label, child in sorted(node.children.items())]
+
+        offset = len(out)
+        out.extend(struct.pack("<III", node.frequency, node.best, len(offsets)))
+        for label, child in offsets:
+            out.extend(struct.pack("<HHI", label, 0, child))
+        return offset
+
+    rootoffset = emit(root)
+    out[0:16] = b"TVKTRIE1" + struct.pack("<II", rootoffset, count)
+    return out
+
+if len(sys.argv) != 3:
+    sys.exit("usage: maketrie.py words.txt output.trie")
+
+words = read_words(sys.argv[1])
+with open(sys.argv[2], "wb") as f:
+    f.write(write(build(words), len(words)))
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 Lyndon Hill
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Convert the action key XPMs to RGB32 arrays so they are not parsed at run time.
+# Run from this directory after changing an XPM:
+#
+#   python3 makeactionkeys.py > actionkeys.h
+
+import re
+import sys
+
+keys  = ["backspace", "tab", "enter", "shift", "font"]
+sizes = ["small", "medium", "large"]
+
+def read_xpm(name):
+    with open(name + ".xpm") as f:
+        rows = re.findall(r'"([^"]*)"', f.read())
+
+    width, height, ncolours, cpp = [int(v) for v in rows[0].split()]
+
+    colours = {}
+    for line in rows[1:1+ncolours]:
+        key = line[:cpp]
+        value = line[cpp:].split()
+        colours[key] = 0xff000000 | int(value[value.index("c")+1][1:], 16)
+
+    pixels = []
+    for line in rows[1+ncolours:1+ncolours+height]:
+        for x in range(width):
+            pixels.append(colours[line[x*cpp:(x+1)*cpp]])
+
+    return width, height, pixels
+
+out = sys.stdout
+
+out.write("/* Generated by makeactionkeys.py from the XPMs in this directory, do not edit */\n\n")
+out.write("#ifndef actionkeys_h\n#define actionkeys_h\n\n")
+
+for key in keys:
+    for size in sizes:
+        name = key + "_" + size
+        width, height, pixels = read_xpm(name)
+
+        out.write("static const unsigned int %s_rgb32[%d] = {\n" % (name, width*height))
+        for y in range(height):
+            row = pixels[y*width:(y+1)*width]
+            out.write("  " + ", ".join("0x%08x" % p for p in row) + ",\n")
+        out.write("};\n\n")
+
+out.write("/// Width, height and pixels of each action key, by key then size\n")
+out.write("static const struct { int width; int height; const unsigned int *pixels; } actionkeys[%d][%d] = {\n"
+          % (len(keys), len(sizes)))
+for key in keys:
+    entries = []
+    for size in sizes:
+        name = key + "_" + size
+        width, height, pixels = read_xpm(name)
+        entries.append("{ %d, %d, %s_rgb32 }" % (width, height, name))
+    out.write("  { " + ", ".join(entries) + " },\n")
+out.write("};\n\n")
+
+out.write("#endif  // actionkeys_h\n")
@@ -0,0 +1,569 @@
+/**
+ * @file   TVKEventRecorder.cc
+ * @brief  Recording of the input events delivered to a keyboard, for replaying
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKEventRecorder.h"
+#include "ThaiVirtualKeyboard.h"
+#include "TVKKeyGeometry.h"
+#include "TVKKeyTable.h"
+#include "TVKLayout.h"
+#include "TVKSequenceCheck.h"
+#include "TVKTrie.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QHash>
+#include <QPair>
+#include <QMouseEvent>
+#include <QTouchEvent>
+#include <QKeyEvent>
+#include <QResizeEvent>
+
+#include <string.h>
+
+// Start of a trace file, and the version of the format after it
+static const char traceMagic[8] = { 'T', 'V', 'K', 'T', 'R', 'A', 'C', 'E' };
+static const quint16 traceVersion = 3;
+
+// Write to a file. Each event is a type, the time since the event before in us and only the
+// fields used by that type, so a trace of a day of typing stays small
+bool TVKEventTrace::save(const QString &filename) const
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::WriteOnly))
+    return(false);
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_6_0);
+  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  out.writeRawData(traceMagic, sizeof(traceMagic));
+  out << traceVersion;
+
+  out << (qint32)setup.size.width() << (qint32)setup.size.height() << setup.layout << setup.fontName
+      << (qint32)setup.fontSize << (quint8)setup.checkMode << setup.correct << (quint8)setup.memoryMode
+      << setup.dictionary << setup.physicalKeys;
+
+  out << (quint32)events.size();
+
+  quint64 previous = 0;
+
+  for(int a = 0; a < events.size(); a++)
+  {
+    const TVKTraceEvent &event = events.at(a);
+
+    out << (quint8)event.type << (quint32)qMin(event.time - previous, (quint64)0xffffffff);
+    previous = event.time;
+
+    switch(event.type)
+    {
+      case TVKTraceEvent::MousePress:
+      case TVKTraceEvent::MouseRelease:
+      out << (float)event.position.x() << (float)event.position.y();
+      break;
+
+      case TVKTraceEvent::TouchPress:
+      case TVKTraceEvent::TouchRelease:
+      out << (qint32)event.id << (float)event.position.x() << (float)event.position.y();
+      break;
+
+      case TVKTraceEvent::KeyPress:
+      case TVKTraceEvent::KeyRelease:
+      out << (qint32)event.key << event.modifiers << event.scanCode << event.virtualKey << event.text;
+      break;
+
+      case TVKTraceEvent::Resize:
+      out << (qint32)event.position.x() << (qint32)event.position.y();
+      break;
+
+      case TVKTraceEvent::Suggestion:
+      out << (quint8)event.id;
+      break;
+
+      case TVKTraceEvent::Emitted:
+      out << (quint8)event.tis620;
+      break;
+
+      default:
+      break;
+    }
+  }
+
+  return(out.status() == QDataStream::Ok);
+}
+
+// Read from a file
+bool TVKEventTrace::load(const QString &filename, QString *error)
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    if(error != NULL) *error = file.errorString();
+    return(false);
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_6_0);
+  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  char magic[sizeof(traceMagic)];
+  quint16 version = 0;
+
+  if((in.readRawData(magic, sizeof(magic)) != sizeof(magic)) || (memcmp(magic, traceMagic, sizeof(magic)) != 0))
+  {
+    if(error != NULL) *error = "not a trace file";
+    return(false);
+  }
+
+  in >> version;
+  if(version != traceVersion)
+  {
+    if(error != NULL) *error = QString("trace version %1 is not supported").arg(version);
+    return(false);
+  }
+
+  qint32 width, height, fontSize;
+  quint8 checkMode, memoryMode;
+  quint32 count;
+
+  in >> width >> height >> setup.layout >> setup.fontName >> fontSize >> checkMode >> setup.correct
+     >> memoryMode >> setup.dictionary >> setup.physicalKeys >> count;
+
+  setup.size       = QSize(width, height);
+  setup.fontSize   = fontSize;
+  setup.checkMode  = qMin((int)checkMode, (int)TVKSequenceCheck::Strict);
+  setup.memoryMode = qMin((int)memoryMode, (int)ThaiVirtualKeyboard::Compressed);
+
+  events.clear();
+
+  quint64 time = 0;
+
+  for(quint32 a = 0; (a < count) && (in.status() == QDataStream::Ok); a++)
+  {
+    TVKTraceEvent event;
+    quint8 type;
+    quint32 gap;
+    float x, y;
+    qint32 id, key, w, h;
+    quint8 tis620, cell;
+
+    in >> type >> gap;
+
+    if(type > TVKTraceEvent::Emitted)
+    {
+      if(error != NULL) *error = QString("event %1 has an unknown type").arg(a);
+      return(false);
+    }
+
+    time += gap;
+    event.type = (TVKTraceEvent::Type)type;
+    event.time = time;
+
+    switch(event.type)
+    {
+      case TVKTraceEvent::MousePress:
+      case TVKTraceEvent::MouseRelease:
+      in >> x >> y;
+      event.position = QPointF(x, y);
+      break;
+
+      case TVKTraceEvent::TouchPress:
+      case TVKTraceEvent::TouchRelease:
+      in >> id >> x >> y;
+      event.id       = id;
+      event.position = QPointF(x, y);
+      break;
+
+      case TVKTraceEvent::KeyPress:
+      case TVKTraceEvent::KeyRelease:
+      in >> key >> event.modifiers >> event.scanCode >> event.virtualKey >> event.text;
+      event.key = key;
+      break;
+
+      case TVKTraceEvent::Resize:
+      in >> w >> h;
+      event.position = QPointF(w, h);
+      break;
+
+      case TVKTraceEvent::Suggestion:
+      in >> cell;
+      event.id = cell;
+      break;
+
+      case TVKTraceEvent::Emitted:
+      in >> tis620;
+      event.tis620 = tis620;
+      break;
+
+      default:
+      break;
+    }
+
+    events.append(event);
+  }
+
+  if(in.status() != QDataStream::Ok)
+  {
+    if(error != NULL) *error = "trace file is truncated";
+    return(false);
+  }
+
+  return(true);
+}
+
+// Add a press and release of a key, with the key press emitted as the key goes down
+static void tap(QList<TVKTraceEvent> &events, const QPointF &position, quint64 time, int hold, int tis620)
+{
+  TVKTraceEvent event;
+  event.type     = TVKTraceEvent::MousePress;
+  event.time     = time;
+  event.position = position;
+  events.append(event);
+
+  if(tis620 != -1)
+  {
+    TVKTraceEvent emitted;
+    emitted.type   = TVKTraceEvent::Emitted;
+    emitted.time   = time;
+    emitted.tis620 = tis620;
+    events.append(emitted);
+  }
+
+  event.type = TVKTraceEvent::MouseRelease;
+  event.time = time + (quint64)hold*1000;
+  events.append(event);
+}
+
+// Make events that type some text. Each character is pressed on the lowest layer that has it,
+// with shift pressed first to step through the layers as the keyboard does. Characters that
+// are not on the layout are left out
+bool TVKEventTrace::fromText(const QString &text, int interval, int hold, QString *error)
+{
+  QSharedPointer<const TVKLayout> layout = TVKLayouts::find(setup.layout);
+  if(layout.isNull())
+  {
+    if(error != NULL) *error = QString("there is no layout \"%1\"").arg(setup.layout);
+    return(false);
+  }
+
+  // Without suggestions or checking every character typed is emitted as it is, and the keys
+  // start at the top of the widget
+  setup.dictionary.clear();
+  setup.checkMode = TVKSequenceCheck::Off;
+
+  TVKKeyGeometry geometry;
+  geometry.setSize(setup.size.width(), setup.size.height());
+
+  // Key and layer for each TIS-620 value, higher layers first so the lowest is kept
+  QHash<int, QPair<int, int> > where;
+  int shift = -1;
+  int layers = layout->layers.size();
+
+  for(int layer = layers-1; layer >= 0; layer--)
+  {
+    for(int k = 0; k < geometry.count(); k++)
+    {
+      const TVKKey &key = geometry.key(k);
+      const TVKKeyDescriptor &d = layout->layers.at(layer).key(key.row, key.column);
+
+      if(d.kind == TVKKeyDescriptor::Shift)
+        shift = k;
+      else if(d.sendsKey())
+        where.insert(d.tis620, qMakePair(layer, k));
+    }
+  }
+
+  events.clear();
+
+  quint64 time = 0;
+  int current = 0;
+
+  for(int a = 0; a < text.size(); a++)
+  {
+    QChar c = text.at(a);
+    int tis620 = (c == '\n') ? 10 : (c == '\t') ? 9 : (c == ' ') ? 32 : tvkTIS620(c.unicode());
+
+    if(!where.contains(tis620))
+      continue;
+
+    QPair<int, int> at = where.value(tis620);
+
+    if((at.first != current) && (shift == -1))
+      continue;
+
+    // Shift steps to the next layer when it is released
+    while(current != at.first)
+    {
+      tap(events, geometry.key(shift).centre, time, hold, -1);
+      time += (quint64)interval*1000;
+      current = (current + 1) % layers;
+    }
+
+    tap(events, geometry.key(at.second).centre, time, hold, tis620);
+    time += (quint64)interval*1000;
+
+    if(layout->layers.at(current).latched == false)
+      current = 0;
+  }
+
+  return(true);
+}
+
+// TIS-620 values emitted, in order
+QList<int> TVKEventTrace::emitted() const
+{
+  QList<int> values;
+
+  for(int a = 0; a < events.size(); a++)
+  {
+    if(events.at(a).type == TVKTraceEvent::Emitted)
+      values.append(events.at(a).tis620);
+  }
+
+  return(values);
+}
+
+// Constructor
+TVKEventRecorder::TVKEventRecorder(QObject *parent) : QObject(parent)
+{
+  keyboard = NULL;
+}
+
+// Start recording a keyboard
+void TVKEventRecorder::start(ThaiVirtualKeyboard *kb)
+{
+  stop();
+
+  keyboard = kb;
+
+  recorded = TVKEventTrace();
+  recorded.setup = setup(kb);
+
+  keyboard->installEventFilter(this);
+  connect(keyboard, SIGNAL(KeyPressed(int)), this, SLOT(keyPressed(int)));
+  connect(keyboard, SIGNAL(destroyed()), this, SLOT(keyboardDestroyed()));
+  watchSuggestions();
+
+  clock.start();
+}
+
+// Follow the suggestions, which are chosen on a child widget the event filter does not see
+void TVKEventRecorder::watchSuggestions()
+{
+  if(keyboard->predictionBar != NULL)
+    connect(keyboard->predictionBar, SIGNAL(suggestionChosen(int,quint64)), this, SLOT(suggestionChosen(int)),
+            Qt::UniqueConnection);
+}
+
+// Stop recording
+void TVKEventRecorder::stop()
+{
+  if(keyboard == NULL)
+    return;
+
+  keyboard->removeEventFilter(this);
+  disconnect(keyboard, NULL, this, NULL);
+
+  if(keyboard->predictionBar != NULL)
+    disconnect(keyboard->predictionBar, NULL, this, NULL);
+
+  keyboard = NULL;
+}
+
+// The keyboard went away while recording
+void TVKEventRecorder::keyboardDestroyed()
+{
+  keyboard = NULL;
+}
+
+// How a keyboard is set up
+TVKTraceSetup TVKEventRecorder::setup(const ThaiVirtualKeyboard *kb)
+{
+  TVKTraceSetup s;
+
+  s.size         = kb->size();
+  s.layout       = kb->currentLayout->name;
+  s.fontName     = kb->tvkFontName;
+  s.fontSize     = kb->tvkFontSize;
+  s.checkMode    = kb->sequenceCheck.mode();
+  s.correct      = kb->sequenceCheck.corrects();
+  s.memoryMode   = kb->memoryMode;
+  s.physicalKeys = kb->physicalKeys;
+
+  if(kb->dictionary != NULL)
+    s.dictionary = kb->dictionary->fileName();
+
+  return(s);
+}
+
+// Set up a keyboard as it was recorded, the size last as the font sets the smallest size
+bool TVKEventRecorder::restore(ThaiVirtualKeyboard *kb, const TVKTraceSetup &s, QString *error)
+{
+  if(!kb->setLayout(s.layout))
+  {
+    if(error != NULL) *error = QString("there is no layout \"%1\"").arg(s.layout);
+    return(false);
+  }
+
+  if(!kb->setDictionary(s.dictionary))
+  {
+    if(error != NULL) *error = QString("cannot open dictionary \"%1\"").arg(s.dictionary);
+    return(false);
+  }
+
+  kb->setSequenceCheck((TVKSequenceCheck::Mode)s.checkMode, s.correct);
+  kb->setMemoryMode((ThaiVirtualKeyboard::MemoryMode)s.memoryMode);
+  kb->setPhysicalKeys(s.physicalKeys);
+
+  kb->tvkFontName = s.fontName;
+  kb->tvkFontSize = s.fontSize;
+  kb->refreshFont();
+
+  kb->resize(s.size);
+  kb->finishResize();
+
+  // The keys would not be where the events were recorded
+  if(kb->size() != s.size)
+  {
+    if(error != NULL)
+      *error = QString("keyboard cannot be %1x%2 with this font, it is %3x%4")
+               .arg(s.size.width()).arg(s.size.height()).arg(kb->width()).arg(kb->height());
+    return(false);
+  }
+
+  return(true);
+}
+
+// Record the events delivered to the keyboard, before the keyboard sees them
+bool TVKEventRecorder::eventFilter(QObject *o, QEvent *e)
+{
+  if((keyboard == NULL) || (o != keyboard))
+    return(QObject::eventFilter(o, e));
+
+  TVKTraceEvent event;
+
+  switch(e->type())
+  {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    {
+      QMouseEvent *m = static_cast<QMouseEvent *>(e);
+      if(m->button() != Qt::LeftButton)
+        break;
+
+      event.type     = (e->type() == QEvent::MouseButtonPress) ? TVKTraceEvent::MousePress : TVKTraceEvent::MouseRelease;
+      event.position = m->position();
+      add(event);
+      break;
+    }
+
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    {
+      // Only points that went down or up change the keyboard
+      const QList<QEventPoint> &points = static_cast<QTouchEvent *>(e)->points();
+
+      for(int a = 0; a < points.size(); a++)
+      {
+        const QEventPoint &point = points.at(a);
+
+        if(point.state() == QEventPoint::Pressed)
+          event.type = TVKTraceEvent::TouchPress;
+        else if(point.state() == QEventPoint::Released)
+          event.type = TVKTraceEvent::TouchRelease;
+        else
+          continue;
+
+        event.id       = point.id();
+        event.position = point.position();
+        add(event);
+      }
+      break;
+    }
+
+    case QEvent::TouchCancel:
+    event.type = TVKTraceEvent::TouchCancel;
+    add(event);
+    break;
+
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    {
+      // Native codes are kept for physical keys
+      QKeyEvent *k = static_cast<QKeyEvent *>(e);
+
+      event.type       = (e->type() == QEvent::KeyPress) ? TVKTraceEvent::KeyPress : TVKTraceEvent::KeyRelease;
+      event.key        = k->key();
+      event.modifiers  = k->modifiers().toInt();
+      event.scanCode   = k->nativeScanCode();
+      event.virtualKey = k->nativeVirtualKey();
+      event.text       = k->text();
+      add(event);
+      break;
+    }
+
+    case QEvent::ChildPolished:
+    // A row of suggestions is added when a dictionary is set
+    watchSuggestions();
+    break;
+
+    case QEvent::Resize:
+    {
+      QSize size = static_cast<QResizeEvent *>(e)->size();
+
+      event.type     = TVKTraceEvent::Resize;
+      event.position = QPointF(size.width(), size.height());
+      add(event);
+      break;
+    }
+
+    default:
+    break;
+  }
+
+  return(QObject::eventFilter(o, e));
+}
+
+// Record a key press emitted by the keyboard
+void TVKEventRecorder::keyPressed(int tis620)
+{
+  TVKTraceEvent event;
+  event.type   = TVKTraceEvent::Emitted;
+  event.tis620 = tis620;
+  add(event);
+}
+
+// Record a suggestion chosen, the key presses it sends are recorded as they are emitted
+void TVKEventRecorder::suggestionChosen(int index)
+{
+  TVKTraceEvent event;
+  event.type = TVKTraceEvent::Suggestion;
+  event.id   = index;
+  add(event);
+}
+
+// Add an event at the time now
+void TVKEventRecorder::add(TVKTraceEvent &event)
+{
+  event.time = clock.nsecsElapsed()/1000;
+  recorded.events.append(event);
+}
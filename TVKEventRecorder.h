@@ -0,0 +1,201 @@
+/**
+ * @file   TVKEventRecorder.h
+ * @brief  Recording of the input events delivered to a keyboard, for replaying
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKEventRecorder_h
+#define TVKEventRecorder_h
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QSize>
+#include <QPointF>
+#include <QElapsedTimer>
+
+class ThaiVirtualKeyboard;
+
+/// @struct One event of a trace
+struct TVKTraceEvent
+{
+  /// What happened
+  enum Type : quint8
+  {
+    MousePress,     ///< Left button pressed
+    MouseRelease,   ///< Left button released
+    TouchPress,     ///< Touch point pressed
+    TouchRelease,   ///< Touch point released
+    TouchCancel,    ///< Every touch point cancelled
+    KeyPress,       ///< Physical key pressed
+    KeyRelease,     ///< Physical key released
+    Resize,         ///< Widget resized, position holds the size
+    Suggestion,     ///< Suggested word chosen, id holds its cell
+    Emitted         ///< KeyPressed was emitted, replaying checks these
+  };
+
+  /// Constructor
+  TVKTraceEvent() : type(MousePress), time(0), id(0), key(0), modifiers(0), scanCode(0), virtualKey(0), tis620(0) { }
+
+  /// What happened
+  Type type;
+
+  /// Time since the trace started, us
+  quint64 time;
+
+  /// Position in the widget, or the new size
+  QPointF position;
+
+  /// Touch point, or cell of a suggestion
+  int id;
+
+  /// Qt key code
+  int key;
+
+  /// Keyboard modifiers
+  quint32 modifiers;
+
+  /// Native scan code of the key
+  quint32 scanCode;
+
+  /// Native virtual key code of the key
+  quint32 virtualKey;
+
+  /// Text of the key
+  QString text;
+
+  /// TIS-620 value emitted
+  int tis620;
+};
+
+/// @struct How the keyboard was set up when the trace started
+struct TVKTraceSetup
+{
+  /// Constructor
+  TVKTraceSetup() : fontSize(24), checkMode(0), correct(true), memoryMode(0), physicalKeys(false) { }
+
+  /// Size of the widget
+  QSize size;
+
+  /// Name of the layout
+  QString layout;
+
+  /// Name of font
+  QString fontName;
+
+  /// Size of font
+  int fontSize;
+
+  /// TVKSequenceCheck::Mode
+  int checkMode;
+
+  /// The sequence check corrects marks typed in the wrong order
+  bool correct;
+
+  /// ThaiVirtualKeyboard::MemoryMode
+  int memoryMode;
+
+  /// Physical keys type on the keyboard
+  bool physicalKeys;
+
+  /// Dictionary file, empty if not suggesting words
+  QString dictionary;
+};
+
+/// @struct Events delivered to a keyboard and the key presses it emitted
+struct TVKEventTrace
+{
+  /// Setup of the keyboard
+  TVKTraceSetup setup;
+
+  /// Events in time order
+  QList<TVKTraceEvent> events;
+
+  /// Write to a file, false if it cannot be written
+  bool save(const QString &filename) const;
+
+  /// Read from a file, false with a reason if it cannot be read
+  bool load(const QString &filename, QString *error = NULL);
+
+  /// Make events that type some text on the layout of the setup, with interval ms from one
+  /// press to the next and each key held for hold ms. The keys are laid out at the size of the
+  /// setup, which the font must not make larger. False if the layout does not exist
+  bool fromText(const QString &text, int interval = 150, int hold = 60, QString *error = NULL);
+
+  /// TIS-620 values emitted, in order
+  QList<int> emitted() const;
+};
+
+/// @class Records the input events delivered to a keyboard and the key presses it emits
+class TVKEventRecorder : public QObject
+{
+  Q_OBJECT
+
+public:
+  /// Constructor
+  TVKEventRecorder(QObject *parent = NULL);
+
+  /// Start recording a keyboard, anything recorded before is cleared
+  void start(ThaiVirtualKeyboard *keyboard);
+
+  /// Stop recording
+  void stop();
+
+  /// Events recorded
+  const TVKEventTrace &trace() const { return(recorded); }
+
+  /// How a keyboard is set up
+  static TVKTraceSetup setup(const ThaiVirtualKeyboard *keyboard);
+
+  /// Set up a keyboard as it was recorded. False with a reason if the layout or dictionary cannot
+  /// be found, or the font makes the keyboard larger than the size recorded
+  static bool restore(ThaiVirtualKeyboard *keyboard, const TVKTraceSetup &setup, QString *error = NULL);
+
+protected:
+  /// Record the events delivered to the keyboard, they are not changed
+  bool eventFilter(QObject *o, QEvent *e);
+
+private slots:
+  /// Record a key press emitted by the keyboard
+  void keyPressed(int tis620);
+
+  /// Record a suggestion chosen on the row above the keys
+  void suggestionChosen(int index);
+
+  /// The keyboard went away while recording
+  void keyboardDestroyed();
+
+private:
+  /// Add an event at the time now
+  void add(TVKTraceEvent &event);
+
+  /// Follow the suggestions of the keyboard, if it has a row of them
+  void watchSuggestions();
+
+  /// Keyboard recorded, NULL if not recording
+  ThaiVirtualKeyboard *keyboard;
+
+  /// Time since recording started
+  QElapsedTimer clock;
+
+  /// Events recorded
+  TVKEventTrace recorded;
+};
+
+#endif  // TVKEventRecorder_h
@@ -0,0 +1,154 @@
+/**
+ * @file   TVKFontChooser.cc
+ * @brief  Choose a font from the fonts that support Thai
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKFontChooser.h"
+#include "TVKFontIndex.h"
+
+#include <QFontDialog>
+#include <QListWidget>
+#include <QListWidgetItem>
+#include <QSpinBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QStringList>
+
+// Shown after each family name, family names are not always written in Thai
+static const char *sample = "  \xe0\xb8\x81\xe0\xb8\x82\xe0\xb8\x84 \xe0\xb9\x91\xe0\xb9\x92\xe0\xb9\x93";
+
+// Choose a font
+QFont TVKFontChooser::getFont(bool *ok, const QFont &initial, QWidget *parent, const QString &title)
+{
+  TVKFontIndex *index = TVKFontIndex::instance();
+
+  if(!index->isReady() || index->families().isEmpty())
+    return(standardFont(ok, initial, parent, title));
+
+  TVKFontChooser chooser(initial, parent, title);
+
+  *ok = (chooser.exec() == QDialog::Accepted);
+  if(*ok == false)
+    return(initial);
+
+  return(chooser.selectedFont());
+}
+
+// Standard font dialog
+QFont TVKFontChooser::standardFont(bool *ok, const QFont &initial, QWidget *parent, const QString &title)
+{
+#ifdef __APPLE__
+  return(QFontDialog::getFont(ok, initial, parent, title, QFontDialog::DontUseNativeDialog));
+#else
+  return(QFontDialog::getFont(ok, initial, parent, title));
+#endif
+}
+
+// Constructor
+TVKFontChooser::TVKFontChooser(const QFont &initial, QWidget *parent, const QString &title) : QDialog(parent)
+{
+  setWindowTitle(title);
+
+  otherChosen   = false;
+  currentFamily = initial.family();
+
+  familyList = new QListWidget(this);
+
+  sizeBox = new QSpinBox(this);
+  sizeBox->setRange(1, 400);
+  sizeBox->setValue(initial.pointSize() > 0 ? initial.pointSize() : TVKFontIndex::referenceSize);
+
+  QPushButton *all = new QPushButton("All Fonts...", this);
+  connect(all, SIGNAL(clicked()), this, SLOT(allFonts()));
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+  connect(buttons, SIGNAL(accepted()), this, SLOT(accept()));
+  connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+  connect(familyList, SIGNAL(itemDoubleClicked(QListWidgetItem*)), this, SLOT(accept()));
+
+  QHBoxLayout *sizerow = new QHBoxLayout;
+  sizerow->addWidget(new QLabel("Size", this));
+  sizerow->addWidget(sizeBox);
+  sizerow->addStretch();
+  sizerow->addWidget(all);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(familyList);
+  layout->addLayout(sizerow);
+  layout->addWidget(buttons);
+
+  fillFamilies();
+
+  // The index may be rebuilt while the dialog is open
+  connect(TVKFontIndex::instance(), SIGNAL(updated()), this, SLOT(fillFamilies()));
+}
+
+// Fill the list from the index, each family is shown in its own font
+void TVKFontChooser::fillFamilies()
+{
+  QListWidgetItem *selected = familyList->currentItem();
+  if(selected != NULL)
+    currentFamily = selected->data(Qt::UserRole).toString();
+
+  QStringList families = TVKFontIndex::instance()->families();
+
+  familyList->clear();
+
+  for(int a = 0; a < families.size(); a++)
+  {
+    QListWidgetItem *item = new QListWidgetItem(families.at(a) + QString::fromUtf8(sample), familyList);
+    item->setData(Qt::UserRole, families.at(a));
+
+    QFont f(families.at(a));
+    f.setPointSize(familyList->font().pointSize());
+    item->setFont(f);
+
+    if(families.at(a) == currentFamily)
+      familyList->setCurrentItem(item);
+  }
+}
+
+// Choose from every font with the standard font dialog
+void TVKFontChooser::allFonts()
+{
+  bool ok;
+
+  QFont font = standardFont(&ok, selectedFont(), this, windowTitle());
+  if(ok)
+  {
+    otherFont   = font;
+    otherChosen = true;
+    accept();
+  }
+}
+
+// The chosen font
+QFont TVKFontChooser::selectedFont() const
+{
+  if(otherChosen)
+    return(otherFont);
+
+  QListWidgetItem *item = familyList->currentItem();
+
+  return(QFont((item != NULL) ? item->data(Qt::UserRole).toString() : currentFamily, sizeBox->value()));
+}
@@ -0,0 +1,75 @@
+/**
+ * @file   TVKFontChooser.h
+ * @brief  Choose a font from the fonts that support Thai
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKFontChooser_h
+#define TVKFontChooser_h
+
+#include <QDialog>
+#include <QFont>
+#include <QString>
+
+class QListWidget;
+class QSpinBox;
+
+/// @class Font dialog listing only the fonts in the Thai font index
+class TVKFontChooser : public QDialog
+{
+  Q_OBJECT
+
+public:
+  /// Choose a font, falls back to the standard font dialog until the index is ready
+  static QFont getFont(bool *ok, const QFont &initial, QWidget *parent, const QString &title);
+
+private slots:
+  /// Fill the list from the index
+  void fillFamilies();
+
+  /// Choose from every font with the standard font dialog
+  void allFonts();
+
+private:
+  /// Constructor
+  TVKFontChooser(const QFont &initial, QWidget *parent, const QString &title);
+
+  /// The chosen font
+  QFont selectedFont() const;
+
+  /// Standard font dialog
+  static QFont standardFont(bool *ok, const QFont &initial, QWidget *parent, const QString &title);
+
+  /// Font families
+  QListWidget *familyList;
+
+  /// Point size
+  QSpinBox *sizeBox;
+
+  /// Family selected when the list is filled
+  QString currentFamily;
+
+  /// Font chosen from the standard dialog
+  QFont otherFont;
+
+  /// A font was chosen from the standard dialog
+  bool otherChosen;
+};
+
+#endif  // TVKFontChooser_h
@@ -0,0 +1,203 @@
+/**
+ * @file   TVKFontIndex.cc
+ * @brief  Thai fonts on the system, found once in the background
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKFontIndex.h"
+#include "TVKInstrumentation.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QFontDatabase>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QSettings>
+#include <QCryptographicHash>
+
+const int TVKFontIndex::referenceSize;
+
+// Get the index, only call from the GUI thread
+TVKFontIndex *TVKFontIndex::instance()
+{
+  static TVKFontIndex *index = NULL;
+
+  if(index == NULL)
+  {
+    // Owned by the application so the thread is stopped before exit
+    index = new TVKFontIndex(QCoreApplication::instance());
+    index->start(QThread::LowPriority);
+  }
+
+  return(index);
+}
+
+// Constructor, loads the saved index
+TVKFontIndex::TVKFontIndex(QObject *parent) : QThread(parent)
+{
+  ready = false;
+
+  TVKScopedTimer timing(TVKInstrumentation::Settings);
+  QSettings settings("lyndonhill.com", "TVK");
+
+  indexFingerprint = settings.value("fontindex/fingerprint").toString();
+  if(indexFingerprint.isEmpty())
+    return;
+
+  int count = settings.beginReadArray("fontindex/fonts");
+  for(int a = 0; a < count; a++)
+  {
+    settings.setArrayIndex(a);
+
+    TVKFontInfo info;
+    info.family       = settings.value("family").toString();
+    info.drawsCircles = settings.value("circles").toBool();
+    info.ascent       = settings.value("ascent").toReal();
+    info.descent      = settings.value("descent").toReal();
+    info.averageWidth = settings.value("width").toReal();
+
+    fonts.insert(info.family, info);
+    names.append(info.family);
+  }
+  settings.endArray();
+
+  ready = true;
+}
+
+// Destructor
+TVKFontIndex::~TVKFontIndex()
+{
+  requestInterruption();
+  wait();
+}
+
+// Build the index, nothing is measured if the fonts are the same as last time
+void TVKFontIndex::run()
+{
+  QStringList families = QFontDatabase::families(QFontDatabase::Thai);
+  families.sort();
+
+  QString print = fingerprint(families);
+
+  {
+    QMutexLocker lock(&mutex);
+    if(ready && (print == indexFingerprint))
+      return;
+  }
+
+  QHash<QString, TVKFontInfo> found;
+
+  for(int a = 0; a < families.size(); a++)
+  {
+    if(isInterruptionRequested())
+      return;
+
+    found.insert(families.at(a), measure(families.at(a)));
+  }
+
+  {
+    QMutexLocker lock(&mutex);
+
+    fonts = found;
+    names = families;
+    indexFingerprint = print;
+    ready = true;
+  }
+
+  // Keep it for next time
+  {
+    TVKScopedTimer timing(TVKInstrumentation::Settings);
+    QSettings settings("lyndonhill.com", "TVK");
+
+    settings.setValue("fontindex/fingerprint", print);
+    settings.beginWriteArray("fontindex/fonts", families.size());
+    for(int a = 0; a < families.size(); a++)
+    {
+      const TVKFontInfo &info = found[families.at(a)];
+
+      settings.setArrayIndex(a);
+      settings.setValue("family", info.family);
+      settings.setValue("circles", info.drawsCircles);
+      settings.setValue("ascent", info.ascent);
+      settings.setValue("descent", info.descent);
+      settings.setValue("width", info.averageWidth);
+    }
+    settings.endArray();
+  }
+
+  emit updated();
+}
+
+// Measure a font family
+TVKFontInfo TVKFontIndex::measure(const QString &family)
+{
+  TVKFontInfo info;
+  QFontMetricsF fm(QFont(family, referenceSize));
+
+  info.family       = family;
+  info.ascent       = fm.ascent();
+  info.descent      = fm.descent();
+  info.averageWidth = fm.averageCharWidth();
+
+  // A lone mark has no width unless it was put on a dotted circle
+  info.drawsCircles = (fm.horizontalAdvance(QString(QChar(0x0e31))) > 0);
+
+  return(info);
+}
+
+// Something that changes when Thai fonts are installed or removed
+QString TVKFontIndex::fingerprint(const QStringList &families)
+{
+  QCryptographicHash hash(QCryptographicHash::Md5);
+
+  hash.addData(families.join('\n').toUtf8());
+
+  return(QString::fromLatin1(hash.result().toHex()));
+}
+
+// The index has been loaded or built
+bool TVKFontIndex::isReady() const
+{
+  QMutexLocker lock(&mutex);
+
+  return(ready);
+}
+
+// Font families that support Thai, sorted
+QStringList TVKFontIndex::families() const
+{
+  QMutexLocker lock(&mutex);
+
+  return(names);
+}
+
+// Find a font family
+bool TVKFontIndex::find(const QString &family, TVKFontInfo *info) const
+{
+  QMutexLocker lock(&mutex);
+
+  QHash<QString, TVKFontInfo>::const_iterator it = fonts.constFind(family);
+  if(it == fonts.constEnd())
+    return(false);
+
+  if(info != NULL)
+    *info = it.value();
+
+  return(true);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file   TVKFontIndex.h
+ * @brief  Thai fonts on the system, found once in the background
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKFontIndex_h
+#define TVKFontIndex_h
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+/// @struct A font family that supports Thai
+struct TVKFontInfo
+{
+  /// Constructor
+  TVKFontInfo() : drawsCircles(false), ascent(0), descent(0), averageWidth(0) { }
+
+  /// Font family
+  QString family;
+
+  /// The font draws NSM on a dotted circle by itself
+  bool drawsCircles;
+
+  /// Ascent at the reference size
+  qreal ascent;
+
+  /// Descent at the reference size
+  qreal descent;
+
+  /// Average character width at the reference size
+  qreal averageWidth;
+};
+
+/// @class Index of Thai fonts, built on its own thread once per process and kept between runs
+class TVKFontIndex : public QThread
+{
+  Q_OBJECT
+
+public:
+  /// Get the index, the first call loads the saved index and starts checking it
+  static TVKFontIndex *instance();
+
+  /// Destructor
+  ~TVKFontIndex();
+
+  /// The index has been loaded or built
+  bool isReady() const;
+
+  /// Font families that support Thai, sorted
+  QStringList families() const;
+
+  /// Find a font family, false if it does not support Thai or the index is not ready
+  bool find(const QString &family, TVKFontInfo *info = NULL) const;
+
+  /// Point size the metrics are measured at
+  static const int referenceSize = 24;
+
+signals:
+  /// The index was built again because the installed fonts changed
+  void updated();
+
+protected:
+  /// Build the index
+  void run();
+
+private:
+  /// Constructor, loads the saved index
+  TVKFontIndex(QObject *parent);
+
+  /// Measure a font family
+  static TVKFontInfo measure(const QString &family);
+
+  /// Something that changes when Thai fonts are installed or removed
+  static QString fingerprint(const QStringList &families);
+
+  /// Protects everything below, the index is read while it is built
+  mutable QMutex mutex;
+
+  /// Fonts by family
+  QHash<QString, TVKFontInfo> fonts;
+
+  /// Sorted family names
+  QStringList names;
+
+  /// Fingerprint of the fonts in the index
+  QString indexFingerprint;
+
+  /// Loaded or built
+  bool ready;
+};
+
+#endif  // TVKFontIndex_h
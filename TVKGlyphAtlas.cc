@@ -0,0 +1,153 @@
+/**
+ * @file   TVKGlyphAtlas.cc
+ * @brief  Shared cache of rasterised keycap glyphs
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKGlyphAtlas.h"
+
+#include <QPainter>
+#include <QFont>
+#include <QFontMetrics>
+#include <QWeakPointer>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <math.h>
+
+// Get the atlas for a font, shared by every keyboard in the process
+QSharedPointer<TVKGlyphAtlas> TVKGlyphAtlas::atlas(const QString &family, int size, qreal dpr,
+                                                   bool addSpaceNSM, const QStringList &keycaps)
+{
+  // Atlases stay alive only while a keyboard is using them
+  static QHash<QString, QWeakPointer<TVKGlyphAtlas> > atlases;
+  static QMutex mutex;
+
+  // Keyboards are drawn on worker threads too
+  QMutexLocker locker(&mutex);
+
+  QString key = QString("%1/%2/%3/%4").arg(family).arg(size).arg(dpr).arg(addSpaceNSM ? 1 : 0);
+
+  QSharedPointer<TVKGlyphAtlas> found = atlases.value(key).toStrongRef();
+  if(found.isNull())
+  {
+    found = QSharedPointer<TVKGlyphAtlas>(new TVKGlyphAtlas(family, size, dpr, keycaps));
+    atlases.insert(key, found);
+  }
+
+  return(found);
+}
+
+// Constructor, rasterises all keycaps
+TVKGlyphAtlas::TVKGlyphAtlas(const QString &family, int size, qreal dpr, const QStringList &keycaps)
+  : family(family), size(size), dpr(dpr)
+{
+  QFont font(family, size);
+  QFontMetrics fm(font);
+
+  // Measure every keycap, the cell must hold both the ink and the text box
+  // because NSM can draw outside their advance width
+
+  int sheetwidth = 512;
+  int x = 0, y = 0, shelf = 0;
+
+  QListIterator<QString> it(keycaps);
+  while(it.hasNext())
+  {
+    QString cap = it.next();
+    if(cap.isEmpty() || glyphs.contains(cap)) continue;
+
+    QRect box(0, -fm.ascent(), fm.horizontalAdvance(cap), fm.height());
+    QRect cell = fm.boundingRect(cap).united(box).adjusted(-1, -1, 1, 1);
+
+    Glyph g;
+    g.offset = box.topLeft() - cell.topLeft();
+    g.box    = box.size();
+
+    // Pack cells onto shelves
+    if((x + cell.width() > sheetwidth) && (x > 0))
+    {
+      x = 0;
+      y += shelf;
+      shelf = 0;
+    }
+
+    g.cell = QRect(x, y, cell.width(), cell.height());
+    x += cell.width();
+    if(cell.height() > shelf) shelf = cell.height();
+    if(x > sheetwidth) sheetwidth = x;
+
+    glyphs.insert(cap, g);
+  }
+
+  int sheetheight = y + shelf;
+  if(sheetheight < 1) sheetheight = 1;
+
+  sheet = QImage((int)ceil(sheetwidth*dpr), (int)ceil(sheetheight*dpr), QImage::Format_ARGB32_Premultiplied);
+  sheet.setDevicePixelRatio(dpr);
+  sheet.fill(Qt::transparent);
+
+  // Shape and rasterise each keycap once
+
+  QPainter p(&sheet);
+  p.setFont(font);
+  p.setPen(QColor(0,0,0));
+
+  QHashIterator<QString, Glyph> git(glyphs);
+  while(git.hasNext())
+  {
+    git.next();
+    const Glyph &g = git.value();
+
+    // Text is drawn from its baseline
+    QPoint origin = g.cell.topLeft() + g.offset + QPoint(0, fm.ascent());
+
+    p.drawText(origin, git.key());
+  }
+
+  p.end();
+}
+
+// Draw a keycap centred in a rectangle
+void TVKGlyphAtlas::drawKeycap(QPainter *p, const QRect &r, QStringView cap) const
+{
+  // Look up without copying the keycap
+  QHash<QString, Glyph>::const_iterator it = glyphs.constFind(QString::fromRawData((const QChar *)cap.utf16(), cap.size()));
+
+  if(it == glyphs.constEnd())
+  {
+    // Not in the atlas, draw it the slow way
+    p->save();
+    p->setFont(QFont(family, size));
+    p->setPen(QColor(0,0,0));
+    p->drawText(r, Qt::AlignCenter, cap.toString());
+    p->restore();
+    return;
+  }
+
+  const Glyph &g = it.value();
+
+  int tx = r.x() + (r.width()  - g.box.width())/2  - g.offset.x();
+  int ty = r.y() + (r.height() - g.box.height())/2 - g.offset.y();
+
+  QRectF source(g.cell.x()*dpr, g.cell.y()*dpr, g.cell.width()*dpr, g.cell.height()*dpr);
+
+  p->drawImage(QRectF(tx, ty, g.cell.width(), g.cell.height()), sheet, source);
+}
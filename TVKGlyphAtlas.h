@@ -0,0 +1,80 @@
+/**
+ * @file   TVKGlyphAtlas.h
+ * @brief  Shared cache of rasterised keycap glyphs
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKGlyphAtlas_h
+#define TVKGlyphAtlas_h
+
+#include <QString>
+#include <QStringView>
+#include <QStringList>
+#include <QImage>
+#include <QRect>
+#include <QHash>
+#include <QSharedPointer>
+
+class QPainter;
+
+/// @class Keycaps shaped and rasterised once, then drawn by blitting
+class TVKGlyphAtlas
+{
+public:
+  /// Get the atlas for a font, shared by every keyboard in the process
+  static QSharedPointer<TVKGlyphAtlas> atlas(const QString &family, int size, qreal dpr,
+                                             bool addSpaceNSM, const QStringList &keycaps);
+
+  /// Draw a keycap centred in a rectangle
+  void drawKeycap(QPainter *p, const QRect &r, QStringView cap) const;
+
+private:
+  /// Constructor, rasterises all keycaps
+  TVKGlyphAtlas(const QString &family, int size, qreal dpr, const QStringList &keycaps);
+
+  /// Position of a keycap in the atlas
+  struct Glyph
+  {
+    /// Area of sheet containing the glyph, logical pixels
+    QRect cell;
+
+    /// Offset of the text box within the cell
+    QPoint offset;
+
+    /// Size of the text box, used to centre the glyph
+    QSize box;
+  };
+
+  /// Font family
+  QString family;
+
+  /// Font size
+  int size;
+
+  /// Device pixel ratio of the sheet
+  qreal dpr;
+
+  /// Glyphs drawn in black
+  QImage sheet;
+
+  /// Where each keycap is in the sheet
+  QHash<QString, Glyph> glyphs;
+};
+
+#endif  // TVKGlyphAtlas_h
@@ -0,0 +1,230 @@
+/**
+ * @file   TVKInstrumentation.cc
+ * @brief  Latency histograms for the hot paths, cheap when turned off
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKInstrumentation.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtAlgorithms>
+
+Q_LOGGING_CATEGORY(tvkPerf, "tvk.perf", QtInfoMsg)
+
+const int TVKHistogram::buckets;
+
+QAtomicInt TVKInstrumentation::enabled(-1);
+
+// Histogram updated from any thread without locking
+struct TVKAtomicHistogram
+{
+  QAtomicInteger<quint64> count;
+  QAtomicInteger<quint64> total;
+  QAtomicInteger<quint64> minimum;
+  QAtomicInteger<quint64> maximum;
+  QAtomicInteger<quint64> bucket[TVKHistogram::buckets];
+};
+
+// One histogram for each probe, zero initialised before anything runs
+static TVKAtomicHistogram histograms[TVKInstrumentation::Probes];
+
+// Constructor
+TVKHistogram::TVKHistogram() : count(0), total(0), minimum(0), maximum(0)
+{
+  for(int b = 0; b < buckets; b++)
+    bucket[b] = 0;
+}
+
+// Upper bound of the bucket holding a percentile
+quint64 TVKHistogram::percentile(double p) const
+{
+  if(count == 0)
+    return(0);
+
+  quint64 rank = (quint64)(p/100.0*count);
+  if(rank >= count) rank = count-1;
+
+  quint64 seen = 0;
+  for(int b = 0; b < buckets; b++)
+  {
+    seen += bucket[b];
+    if(seen > rank)
+      return(qMin(((quint64)1000) << b, maximum));
+  }
+
+  return(maximum);
+}
+
+// Turn timing on if tvk.perf debug messages are enabled
+bool TVKInstrumentation::initialise()
+{
+  bool on = tvkPerf().isDebugEnabled();
+
+  enabled.testAndSetRelaxed(-1, on ? 1 : 0);
+
+  return(enabled.loadRelaxed() != 0);
+}
+
+// Turn timing on or off
+void TVKInstrumentation::setEnabled(bool on)
+{
+  enabled.storeRelaxed(on ? 1 : 0);
+}
+
+// Add a time in ns
+void TVKInstrumentation::record(Probe probe, quint64 ns)
+{
+  TVKAtomicHistogram &h = histograms[probe];
+
+  quint64 us = ns/1000;
+  int b = (us == 0) ? 0 : 64 - qCountLeadingZeroBits(us);
+  if(b >= TVKHistogram::buckets) b = TVKHistogram::buckets-1;
+
+  h.bucket[b].fetchAndAddRelaxed(1);
+  h.total.fetchAndAddRelaxed(ns);
+
+  // The first time sets the minimum
+  quint64 old = h.minimum.loadRelaxed();
+  while(((old == 0) || (ns < old)) && !h.minimum.testAndSetRelaxed(old, ns, old)) { }
+
+  old = h.maximum.loadRelaxed();
+  while((ns > old) && !h.maximum.testAndSetRelaxed(old, ns, old)) { }
+
+  h.count.fetchAndAddRelaxed(1);
+}
+
+// Copy of a histogram, times recorded while copying may be partly included
+TVKHistogram TVKInstrumentation::histogram(Probe probe)
+{
+  TVKAtomicHistogram &h = histograms[probe];
+  TVKHistogram copy;
+
+  copy.count   = h.count.loadRelaxed();
+  copy.total   = h.total.loadRelaxed();
+  copy.minimum = h.minimum.loadRelaxed();
+  copy.maximum = h.maximum.loadRelaxed();
+
+  for(int b = 0; b < TVKHistogram::buckets; b++)
+    copy.bucket[b] = h.bucket[b].loadRelaxed();
+
+  return(copy);
+}
+
+// Forget everything recorded
+void TVKInstrumentation::reset()
+{
+  for(int p = 0; p < Probes; p++)
+  {
+    TVKAtomicHistogram &h = histograms[p];
+
+    h.count.storeRelaxed(0);
+    h.total.storeRelaxed(0);
+    h.minimum.storeRelaxed(0);
+    h.maximum.storeRelaxed(0);
+
+    for(int b = 0; b < TVKHistogram::buckets; b++)
+      h.bucket[b].storeRelaxed(0);
+  }
+}
+
+// Name of a probe
+QString TVKInstrumentation::name(Probe probe)
+{
+  switch(probe)
+  {
+    case Rasterize:    return("rasterize");
+    case Paint:        return("paint");
+    case HitTest:      return("hittest");
+    case FontMetrics:  return("fontmetrics");
+    case Settings:     return("settings");
+    case PressToPaint: return("presstopaint");
+    case Predict:      return("predict");
+    default:           break;
+  }
+
+  return(QString());
+}
+
+// All histograms as JSON
+QByteArray TVKInstrumentation::toJson()
+{
+  QJsonArray probes;
+
+  for(int p = 0; p < Probes; p++)
+  {
+    TVKHistogram h = histogram((Probe)p);
+    QJsonObject entry;
+    QJsonArray counts;
+
+    for(int b = 0; b < TVKHistogram::buckets; b++)
+      counts.append((double)h.bucket[b]);
+
+    entry["name"]     = name((Probe)p);
+    entry["count"]    = (double)h.count;
+    entry["total_ns"] = (double)h.total;
+    entry["min_ns"]   = (double)h.minimum;
+    entry["max_ns"]   = (double)h.maximum;
+    entry["mean_ns"]  = (h.count > 0) ? (double)h.total/h.count : 0.0;
+    entry["p50_ns"]   = (double)h.percentile(50);
+    entry["p90_ns"]   = (double)h.percentile(90);
+    entry["p99_ns"]   = (double)h.percentile(99);
+    entry["buckets"]  = counts;
+
+    probes.append(entry);
+  }
+
+  QJsonObject report;
+  report["probes"] = probes;
+
+  return(QJsonDocument(report).toJson());
+}
+
+// Write all histograms to tvk.perf, one line for each probe that has been used
+void TVKInstrumentation::dump()
+{
+  for(int p = 0; p < Probes; p++)
+  {
+    TVKHistogram h = histogram((Probe)p);
+    if(h.count == 0)
+      continue;
+
+    qCInfo(tvkPerf, "%s: n=%llu mean=%.1fus min=%.1fus p50<%.1fus p90<%.1fus p99<%.1fus max=%.1fus",
+           qPrintable(name((Probe)p)), h.count, h.total/1000.0/h.count, h.minimum/1000.0,
+           h.percentile(50)/1000.0, h.percentile(90)/1000.0, h.percentile(99)/1000.0, h.maximum/1000.0);
+  }
+}
+
+// Write all histograms to a file as JSON
+bool TVKInstrumentation::dump(const QString &filename)
+{
+  QFile file(filename);
+
+  if(!file.open(QIODevice::WriteOnly))
+  {
+    qCWarning(tvkPerf, "Cannot write %s", qPrintable(filename));
+    return(false);
+  }
+
+  file.write(toJson());
+
+  return(true);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file   TVKInstrumentation.h
+ * @brief  Latency histograms for the hot paths, cheap when turned off
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKInstrumentation_h
+#define TVKInstrumentation_h
+
+#include <QtGlobal>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QString>
+
+/// Instrumentation output, debug messages are off unless enabled with QT_LOGGING_RULES="tvk.perf.debug=true"
+Q_DECLARE_LOGGING_CATEGORY(tvkPerf)
+
+/// @struct Copy of a histogram, times are in ns
+struct TVKHistogram
+{
+  /// Number of buckets, bucket 0 is under 1 us and bucket b is 2^(b-1) to 2^b us
+  static const int buckets = 32;
+
+  /// Constructor
+  TVKHistogram();
+
+  /// Number of times recorded
+  quint64 count;
+
+  /// Total of the times
+  quint64 total;
+
+  /// Shortest time
+  quint64 minimum;
+
+  /// Longest time
+  quint64 maximum;
+
+  /// Times in each bucket
+  quint64 bucket[buckets];
+
+  /// Upper bound of the bucket holding a percentile, 0 to 100
+  quint64 percentile(double p) const;
+};
+
+/// @class Collects latency histograms from any thread
+class TVKInstrumentation
+{
+public:
+  /// What is timed
+  enum Probe
+  {
+    Rasterize,     ///< Drawing a keyboard image
+    Paint,         ///< paintEvent
+    HitTest,       ///< Finding the key under the mouse
+    FontMetrics,   ///< Measuring a font for the keyboard size
+    Settings,      ///< Reading and writing settings
+    PressToPaint,  ///< Mouse press to the highlighted key being painted
+    Predict,       ///< Finding the suggested words for a key press
+    Probes
+  };
+
+  /// Timing is on, the first call turns it on if the tvk.perf debug messages are enabled
+  static bool isEnabled()
+  {
+    int on = enabled.loadRelaxed();
+    return((on < 0) ? initialise() : (on != 0));
+  }
+
+  /// Turn timing on or off
+  static void setEnabled(bool on);
+
+  /// Add a time in ns
+  static void record(Probe probe, quint64 ns);
+
+  /// Copy of a histogram
+  static TVKHistogram histogram(Probe probe);
+
+  /// Forget everything recorded
+  static void reset();
+
+  /// Name of a probe
+  static QString name(Probe probe);
+
+  /// All histograms as JSON
+  static QByteArray toJson();
+
+  /// Write all histograms to tvk.perf
+  static void dump();
+
+  /// Write all histograms to a file as JSON, false if it cannot be written
+  static bool dump(const QString &filename);
+
+private:
+  /// Turn timing on if tvk.perf debug messages are enabled
+  static bool initialise();
+
+  /// 1 = on, 0 = off, -1 = not decided yet
+  static QAtomicInt enabled;
+};
+
+/// @class Times a scope, does nothing unless instrumentation is on
+class TVKScopedTimer
+{
+public:
+  /// Constructor, starts timing
+  TVKScopedTimer(TVKInstrumentation::Probe probe) : probe(probe), running(TVKInstrumentation::isEnabled())
+  {
+    if(running) timer.start();
+  }
+
+  /// Destructor, records the time
+  ~TVKScopedTimer()
+  {
+    if(running) TVKInstrumentation::record(probe, timer.nsecsElapsed());
+  }
+
+private:
+  /// What is timed
+  TVKInstrumentation::Probe probe;
+
+  /// Timing was on at the start
+  bool running;
+
+  /// Clock
+  QElapsedTimer timer;
+};
+
+#endif  // TVKInstrumentation_h
@@ -0,0 +1,181 @@
+/**
+ * @file   TVKKeyGeometry.cc
+ * @brief  Position of every key on the Thai Virtual Keyboard
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKKeyGeometry.h"
+
+// Format of the keyboard, in standard keys
+static const int columns = 15;
+static const int rows    = 5;
+
+// Constructor
+TVKKeyGeometry::TVKKeyGeometry()
+{
+}
+
+// Lay out the keys for a keyboard size
+void TVKKeyGeometry::setSize(int width, int height)
+{
+  if((width == layoutSize.width()) && (height == layoutSize.height()))
+    return;
+
+  layoutSize = QSize(width, height);
+
+  keys.clear();
+  lines.clear();
+  fillers.clear();
+
+  rowAtY.fill(-1, height);
+  keyAtX.fill(-1, width*rows);
+  keyAtPosition.fill(-1, rows*columns);
+
+  if((width < columns) || (height < rows))
+    return;
+
+  float keywidth  = (float)(width)/(float)(columns);
+  float keyheight = (float)(height)/(float)(rows);
+
+  int right  = width-1;
+  int bottom = height-1;
+  int a, y;
+
+  // Top of each row, the grid lines are drawn here
+  int top[rows+1];
+  for(a = 0; a < rows; a++)
+    top[a] = (int)(keyheight*a);
+  top[rows] = bottom;
+
+  for(a = 0; a < rows; a++)
+  {
+    for(y = top[a]; y < ((a == rows-1) ? height : top[a+1]); y++)
+      rowAtY[y] = a;
+  }
+
+  // Outline
+  lines.append(QLine(0, 0, right, 0));
+  lines.append(QLine(0, 0, 0, bottom));
+  lines.append(QLine(0, bottom, right, bottom));
+  lines.append(QLine(right, 0, right, bottom));
+
+  // Rows
+  lines.append(QLine(0, top[1], right, top[1]));
+  lines.append(QLine(0, top[2], (int)(keywidth*13.5), top[2]));
+  lines.append(QLine(0, top[3], right, top[3]));
+  lines.append(QLine(0, top[4], (int)(keywidth*14), top[4]));
+
+  // First row, backspace is at the end
+  for(a = 0; a < 13; a++)
+    addKey(0, a, (int)(keywidth*a), (int)(keywidth*(a+1)), top[0], top[1]);
+  addKey(0, 13, (int)(keywidth*13), right, top[0], top[1]);
+
+  // Second row, tab then half a key offset
+  addKey(1, 0, 0, (int)(keywidth*1.5), top[1], top[2]);
+  for(a = 1; a < 13; a++)
+    addKey(1, a, (int)(keywidth*(a+0.5)), (int)(keywidth*(a+1.5)), top[1], top[2]);
+
+  // Enter is two rows high and wider on the third row
+  addKey(1, 13, (int)(keywidth*13.5), right, top[1], top[2]);
+
+  TVKKey &enter = keys.last();
+  int enterleft = (int)(keywidth*13);
+  enter.area.setBottom(top[2]);
+  enter.lower.setCoords(enterleft+1, top[2]+1, right-1, top[3]-1);
+  enter.centre.setY(top[2]);
+  lines.append(QLine(enterleft, top[2], enterleft, top[3]));
+
+  for(a = enterleft; a < width; a++)
+    keyAtX[2*width+a] = keys.size()-1;
+  keyAtPosition[2*columns+13] = keys.size()-1;
+
+  // Third row, font selector first
+  addKey(2, 0, 0, (int)keywidth, top[2], top[3]);
+  for(a = 1; a < 13; a++)
+    addKey(2, a, (int)(keywidth*a), (int)(keywidth*(a+1)), top[2], top[3]);
+
+  // Fourth row, shift at either end
+  addKey(3, 0, 0, (int)(keywidth*1.5), top[3], top[4]);
+  for(a = 1; a < 12; a++)
+    addKey(3, a, (int)(keywidth*(a+0.5)), (int)(keywidth*(a+1.5)), top[3], top[4]);
+  addKey(3, 12, (int)(keywidth*12.5), (int)(keywidth*14), top[3], top[4]);
+
+  // Last row is the space bar
+  addKey(4, 0, (int)(keywidth*4), (int)(keywidth*11), top[4], bottom);
+
+  // Unused areas, each with a line on its left
+  QRect unused;
+
+  unused.setCoords((int)(keywidth*14)+1, top[3]+1, right-1, top[4]);
+  fillers.append(unused);
+  lines.append(QLine((int)(keywidth*14), top[3], (int)(keywidth*14), top[4]));
+
+  unused.setCoords(1, top[4]+1, (int)(keywidth*4)-1, bottom-1);
+  fillers.append(unused);
+
+  unused.setCoords((int)(keywidth*11)+1, top[4]+1, right-1, bottom-1);
+  fillers.append(unused);
+  lines.append(QLine((int)(keywidth*11), top[4], (int)(keywidth*11), bottom));
+}
+
+// Add a key between grid lines, also adds the line on its left
+void TVKKeyGeometry::addKey(int row, int column, int left, int right, int top, int bottom)
+{
+  TVKKey k;
+
+  k.row    = row;
+  k.column = column;
+  k.area.setCoords(left+1, top+1, right-1, bottom-1);
+  k.centre = k.area.center();
+
+  keys.append(k);
+
+  if(left > 0)
+    lines.append(QLine(left, top, left, bottom));
+
+  // The last key on a row also owns the outline
+  int width = layoutSize.width();
+  int end = (right == width-1) ? width : right;
+
+  for(int x = left; x < end; x++)
+    keyAtX[row*width+x] = keys.size()-1;
+
+  keyAtPosition[row*columns+column] = keys.size()-1;
+}
+
+// Key at a point
+int TVKKeyGeometry::keyAt(const QPoint &pos) const
+{
+  if((pos.x() < 0) || (pos.y() < 0) || (pos.x() >= layoutSize.width()) || (pos.y() >= layoutSize.height()))
+    return(-1);
+
+  int row = rowAtY.at(pos.y());
+  if(row < 0) return(-1);
+
+  return(keyAtX.at(row*layoutSize.width()+pos.x()));
+}
+
+// Key at a keymap position
+int TVKKeyGeometry::find(int row, int column) const
+{
+  if((row < 0) || (row >= rows) || (column < 0) || (column >= columns) || keyAtPosition.isEmpty())
+    return(-1);
+
+  return(keyAtPosition.at(row*columns+column));
+}
@@ -0,0 +1,117 @@
+/**
+ * @file   TVKKeyGeometry.h
+ * @brief  Position of every key on the Thai Virtual Keyboard
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKKeyGeometry_h
+#define TVKKeyGeometry_h
+
+#include <QRect>
+#include <QLine>
+#include <QPoint>
+#include <QSize>
+#include <QVector>
+
+/// @struct One key on the keyboard
+struct TVKKey
+{
+  /// Row of the keymap
+  int row;
+
+  /// Column of the keymap
+  int column;
+
+  /// Area inside the grid lines, used for keycaps and highlighting
+  QRect area;
+
+  /// Lower part of a key that is two rows high, otherwise empty
+  QRect lower;
+
+  /// Where to centre an action key image
+  QPoint centre;
+};
+
+/// @struct A key held down by the mouse or a touch point
+struct TVKPress
+{
+  int id;       ///< Touch point, -1 for the mouse, -2 and below for physical keys
+  int row;      ///< Key row
+  int column;   ///< Key column
+  int layer;    ///< Layer shown when the key was pressed
+};
+
+/// @class Key rectangles and hit-testing for one size of keyboard
+class TVKKeyGeometry
+{
+public:
+  /// Constructor
+  TVKKeyGeometry();
+
+  /// Lay out the keys for a keyboard size, does nothing if the size is unchanged
+  void setSize(int width, int height);
+
+  /// Size the keys are laid out for
+  QSize size() const { return(layoutSize); }
+
+  /// Number of keys
+  int count() const { return(keys.size()); }
+
+  /// Get a key
+  const TVKKey &key(int k) const { return(keys.at(k)); }
+
+  /// Key at a point, -1 if there is no key there
+  int keyAt(const QPoint &pos) const;
+
+  /// Key at a keymap position, -1 if there is no key there
+  int find(int row, int column) const;
+
+  /// Lines between the keys
+  const QVector<QLine> &gridLines() const { return(lines); }
+
+  /// Areas of the keyboard without keys
+  const QVector<QRect> &unusedAreas() const { return(fillers); }
+
+private:
+  /// Add a key
+  void addKey(int row, int column, int left, int right, int top, int bottom);
+
+  /// Size the keys are laid out for
+  QSize layoutSize;
+
+  /// All keys
+  QVector<TVKKey> keys;
+
+  /// Lines between the keys
+  QVector<QLine> lines;
+
+  /// Areas without keys
+  QVector<QRect> fillers;
+
+  /// Row for each y coordinate
+  QVector<qint8> rowAtY;
+
+  /// Key for each x coordinate of each row
+  QVector<qint16> keyAtX;
+
+  /// Key for each keymap position
+  QVector<qint16> keyAtPosition;
+};
+
+#endif  // TVKKeyGeometry_h
@@ -0,0 +1,90 @@
+/**
+ * @file   TVKKeyQueue.cc
+ * @brief  Lock-free queue of key presses for a consumer on another thread
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKKeyQueue.h"
+
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<TVKKeyRecord>::value, "key records are copied as plain data");
+
+// Constructor
+TVKKeyQueue::TVKKeyQueue(int capacity) : head(0), tail(0), droppedCount(0)
+{
+  quint32 size = 2;
+  while((int)size < capacity)
+    size *= 2;
+
+  ring = new TVKKeyRecord[size];
+  mask = size-1;
+}
+
+// Destructor
+TVKKeyQueue::~TVKKeyQueue()
+{
+  delete [] ring;
+}
+
+// Add a key press. Positions are never wrapped, only the index into the ring is,
+// so head - tail is the number waiting even after the counters overflow
+bool TVKKeyQueue::push(const TVKKeyRecord &record)
+{
+  quint32 h = head.loadRelaxed();
+
+  if(h - tail.loadAcquire() > mask)
+  {
+    droppedCount.fetchAndAddRelaxed(1);
+    return(false);
+  }
+
+  ring[h & mask] = record;
+
+  // The record is written before the consumer can see it
+  head.storeRelease(h+1);
+
+  return(true);
+}
+
+// Take up to max key presses
+int TVKKeyQueue::pop(TVKKeyRecord *records, int max)
+{
+  if(max <= 0)
+    return(0);
+
+  quint32 t = tail.loadRelaxed();
+  quint32 available = head.loadAcquire() - t;
+
+  int n = (max < (int)available) ? max : (int)available;
+
+  for(int a = 0; a < n; a++)
+    records[a] = ring[(t+a) & mask];
+
+  // The records are read before the producer can reuse their space
+  tail.storeRelease(t+n);
+
+  return(n);
+}
+
+// Key presses waiting
+int TVKKeyQueue::size() const
+{
+  return((int)(head.loadAcquire() - tail.loadAcquire()));
+}
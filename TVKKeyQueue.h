@@ -0,0 +1,116 @@
+/**
+ * @file   TVKKeyQueue.h
+ * @brief  Lock-free queue of key presses for a consumer on another thread
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKKeyQueue_h
+#define TVKKeyQueue_h
+
+#include <QtGlobal>
+#include <QAtomicInteger>
+
+/// @struct One key press, plain data that is copied into the queue
+struct TVKKeyRecord
+{
+  /// Where the key press came from
+  enum Source { VirtualKey = 0, PassThrough = 1 };
+
+  /// Unicode of a virtual key, backspace, tab and enter are 8, 9 and 10. 0 for pass-through keys
+  quint32 codepoint;
+
+  /// TIS-620 value of a virtual key, 0 for pass-through keys
+  quint16 tis620;
+
+  /// Source of the key press
+  quint8 source;
+
+  /// Index of the layer in the current layout the key was typed on
+  quint8 layer;
+
+  /// Time of the input event, ms
+  quint64 timestamp;
+
+  /// Qt::Key of a pass-through key
+  quint32 key;
+
+  /// Qt::KeyboardModifiers of a pass-through key
+  quint32 modifiers;
+
+  /// Native scan code of a pass-through key
+  quint32 nativeScanCode;
+
+  /// Native virtual key of a pass-through key
+  quint32 nativeVirtualKey;
+
+  /// Number of UTF-16 units in text
+  quint16 textLength;
+
+  /// Text of a pass-through key, UTF-16, truncated
+  char16_t text[4];
+};
+
+/// @class Single producer, single consumer ring of key presses.
+/// The keyboard pushes on the GUI thread, one other thread drains it without locks or events
+class TVKKeyQueue
+{
+public:
+  /// Constructor, capacity is rounded up to a power of two
+  TVKKeyQueue(int capacity = 1024);
+
+  /// Destructor
+  ~TVKKeyQueue();
+
+  /// Add a key press, producer only. False if the queue is full and the key press was dropped
+  bool push(const TVKKeyRecord &record);
+
+  /// Take up to max key presses, consumer only. Returns the number taken
+  int pop(TVKKeyRecord *records, int max);
+
+  /// Key presses waiting, approximate unless called by the consumer
+  int size() const;
+
+  /// Number of records the queue holds
+  int capacity() const { return(mask+1); }
+
+  /// Key presses dropped because the queue was full
+  quint32 dropped() const { return(droppedCount.loadRelaxed()); }
+
+private:
+  /// Not copyable
+  TVKKeyQueue(const TVKKeyQueue &);
+  TVKKeyQueue &operator=(const TVKKeyQueue &);
+
+  /// Storage, capacity records
+  TVKKeyRecord *ring;
+
+  /// Capacity - 1, positions wrap with this
+  quint32 mask;
+
+  /// Next position to write, only changed by the producer
+  alignas(64) QAtomicInteger<quint32> head;
+
+  /// Next position to read, only changed by the consumer
+  alignas(64) QAtomicInteger<quint32> tail;
+
+  /// Key presses dropped
+  alignas(64) QAtomicInteger<quint32> droppedCount;
+};
+
+#endif  // TVKKeyQueue_h
@@ -0,0 +1,239 @@
+/**
+ * @file   TVKKeyTable.h
+ * @brief  What every key on the Thai Virtual Keyboard is, worked out at compile time
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKKeyTable_h
+#define TVKKeyTable_h
+
+#include <QtGlobal>
+#include <QStringView>
+
+#include <array>
+#include <utility>
+
+/// @struct One key of a keymap
+struct TVKKeyDescriptor
+{
+  /// What the key does
+  enum Kind : quint8 { None, Character, Space, Shift, Font, Backspace, Tab, Enter };
+
+  /// TIS-620 value, sent by KeyPressed. Action keys use 1 and 2 for shift, 3 for font and ASCII for the rest
+  quint16 tis620;
+
+  /// Unicode, control keys keep their ASCII code
+  char16_t unicode;
+
+  /// What the key does
+  Kind kind;
+
+  /// Non-spacing mark, drawn on a dotted circle when the renderer does not add one
+  bool nsm;
+
+  /// Keycap, with a dotted circle first for NSM
+  char16_t cap[2];
+
+  /// Keycap, adding a dotted circle to NSM or not
+  constexpr QStringView keycap(bool addSpaceNSM) const
+  {
+    return((nsm && addSpaceNSM) ? QStringView(cap, 2) : QStringView(&unicode, 1));
+  }
+
+  /// Pressing the key sends KeyPressed
+  constexpr bool sendsKey() const { return((kind != None) && (kind != Shift) && (kind != Font)); }
+};
+
+/// Keymaps in TIS-620, the source of the tables below. 0 = no key, 1/2 = left/right shift, 3 = font,
+/// 8 = backspace, 9 = tab, 10 = enter, 32 = space. Keys more than one position wide are repeated
+constexpr int tvk_keymap[75] = {
+  239, 229,  47,  45, 192, 182, 216, 214, 164, 181, 168, 162, 170,  8,  0,
+    9, 230, 228, 211, 190, 208, 209, 213, 195, 185, 194, 186, 197, 10, 10,
+    3, 238, 191, 203, 161, 180, 224, 233, 232, 210, 202, 199, 167,  10, 10,
+    1, 163, 188, 187, 225, 205, 212, 215, 183, 193, 227, 189,   2,  2,  0,
+   32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32, 32, 32 };
+
+constexpr int tvk_shifted_keymap[75] = {
+  251,  43, 241, 242, 243, 244, 217, 223, 245, 246, 247, 248, 249,  8,  0,
+    9, 240,  34, 174, 177, 184, 237, 234, 179, 207, 173, 176,  44, 10, 10,
+    3, 250, 196, 166, 175, 226, 172, 231, 235, 201, 200, 171,  46,  10, 10, 
+    1, 165,  40,  41, 169, 206, 218, 236,  63, 178, 204, 198,   2,  2,  0,
+   32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32, 32, 32 };
+
+// NSM are drawn with a dotted circle. Linux always draws SARA AM (211) with one, so it is left out there
+constexpr bool tvkIsNSM(int tis620)
+{
+#ifdef __linux
+  return((tis620 == 209) || (tis620 > 211 && tis620 < 219) || (tis620 > 230 && tis620 < 239));
+#else
+  return((tis620 == 209) || (tis620 >= 211 && tis620 < 219) || (tis620 > 230 && tis620 < 239));
+#endif
+}
+
+// Unicode for a TIS-620 value
+constexpr char16_t tvkUnicode(int tis620)
+{
+  return((tis620 > 127) ? (char16_t)(tis620 - 0xa0 + 0xe00) : (char16_t)tis620);
+}
+
+// TIS-620 value of a character, -1 if it is not printable ASCII or Thai
+constexpr int tvkTIS620(char16_t u)
+{
+  return(((u > 32) && (u < 127)) ? (int)u :
+         ((u >= 0x0e01) && (u <= 0x0e5b) && ((u < 0x0e3b) || (u > 0x0e3e))) ? (int)(u - 0xe00 + 0xa0) : -1);
+}
+
+// What a key does
+constexpr TVKKeyDescriptor::Kind tvkKind(int tis620)
+{
+  return((tis620 > 32)  ? TVKKeyDescriptor::Character :
+         (tis620 == 32) ? TVKKeyDescriptor::Space :
+         (tis620 == 1 || tis620 == 2) ? TVKKeyDescriptor::Shift :
+         (tis620 == 3)  ? TVKKeyDescriptor::Font :
+         (tis620 == 8)  ? TVKKeyDescriptor::Backspace :
+         (tis620 == 9)  ? TVKKeyDescriptor::Tab :
+         (tis620 == 10) ? TVKKeyDescriptor::Enter : TVKKeyDescriptor::None);
+}
+
+// Describe a key
+constexpr TVKKeyDescriptor tvkDescribe(int tis620)
+{
+  return(TVKKeyDescriptor{ (quint16)tis620, tvkUnicode(tis620), tvkKind(tis620), tvkIsNSM(tis620),
+                           { tvkIsNSM(tis620) ? u'\x25cc' : tvkUnicode(tis620), tvkUnicode(tis620) } });
+}
+
+// Describe every key of a keymap
+template<std::size_t... k>
+constexpr std::array<TVKKeyDescriptor, 75> tvkDescribeAll(const int (&keymap)[75], std::index_sequence<k...>)
+{
+  return(std::array<TVKKeyDescriptor, 75>{{ tvkDescribe(keymap[k])... }});
+}
+
+/// Keys of the keyboard, by row*15 + column
+inline constexpr std::array<TVKKeyDescriptor, 75> tvkKeys = tvkDescribeAll(tvk_keymap, std::make_index_sequence<75>());
+
+/// Keys of the shift keyboard, by row*15 + column
+inline constexpr std::array<TVKKeyDescriptor, 75> tvkShiftedKeys = tvkDescribeAll(tvk_shifted_keymap, std::make_index_sequence<75>());
+
+/// @struct UTF-8 of one character, not terminated
+struct TVKUtf8
+{
+  /// Bytes, Thai takes 3
+  char bytes[3];
+
+  /// Number of bytes
+  quint8 length;
+};
+
+// UTF-8 of a character below U+10000
+constexpr TVKUtf8 tvkUtf8(char16_t u)
+{
+  return((u < 0x80)  ? TVKUtf8{ { (char)u, 0, 0 }, 1 } :
+         (u < 0x800) ? TVKUtf8{ { (char)(0xc0 | (u >> 6)), (char)(0x80 | (u & 0x3f)), 0 }, 2 } :
+                       TVKUtf8{ { (char)(0xe0 | (u >> 12)), (char)(0x80 | ((u >> 6) & 0x3f)), (char)(0x80 | (u & 0x3f)) }, 3 });
+}
+
+// Unicode and UTF-8 of every TIS-620 value
+template<std::size_t... t>
+constexpr std::array<char16_t, 256> tvkUnicodeAll(std::index_sequence<t...>)
+{
+  return(std::array<char16_t, 256>{{ tvkUnicode(t)... }});
+}
+
+template<std::size_t... t>
+constexpr std::array<TVKUtf8, 256> tvkUtf8All(std::index_sequence<t...>)
+{
+  return(std::array<TVKUtf8, 256>{{ tvkUtf8(tvkUnicode(t))... }});
+}
+
+/// Unicode by TIS-620 value, static so views of it stay valid
+inline constexpr std::array<char16_t, 256> tvkUnicodeText = tvkUnicodeAll(std::make_index_sequence<256>());
+
+/// UTF-8 by TIS-620 value, static so pointers into it stay valid
+inline constexpr std::array<TVKUtf8, 256> tvkUtf8Text = tvkUtf8All(std::make_index_sequence<256>());
+
+// Unicode of a TIS-620 value as a view of static storage, nothing is allocated
+constexpr QStringView tvkUnicodeView(int tis620)
+{
+  return(QStringView(&tvkUnicodeText[tis620], 1));
+}
+
+// Checks on the tables, made when compiling
+
+// Action keys are where the key geometry puts them, on both keyboards
+constexpr bool tvkActionKeysPlaced(const std::array<TVKKeyDescriptor, 75> &keys)
+{
+  for(int k = 60; k < 75; k++)
+    if(keys[k].kind != TVKKeyDescriptor::Space) return(false);
+
+  return((keys[13].kind == TVKKeyDescriptor::Backspace) && (keys[15].kind == TVKKeyDescriptor::Tab) &&
+         (keys[28].kind == TVKKeyDescriptor::Enter) && (keys[43].kind == TVKKeyDescriptor::Enter) &&
+         (keys[30].kind == TVKKeyDescriptor::Font) &&
+         (keys[45].kind == TVKKeyDescriptor::Shift) && (keys[57].kind == TVKKeyDescriptor::Shift));
+}
+
+// Every character is printable ASCII or Thai, and only Thai characters are NSM
+constexpr bool tvkCharactersValid(const std::array<TVKKeyDescriptor, 75> &keys)
+{
+  for(int k = 0; k < 75; k++)
+  {
+    if(keys[k].kind != TVKKeyDescriptor::Character)
+      continue;
+
+    bool thai = (keys[k].unicode >= 0x0e01) && (keys[k].unicode <= 0x0e5b);
+    bool ascii = (keys[k].unicode > 32) && (keys[k].unicode < 127);
+
+    if(!thai && !ascii) return(false);
+    if(keys[k].nsm && !thai) return(false);
+    if(thai && (keys[k].unicode - 0xe00 + 0xa0 != keys[k].tis620)) return(false);
+  }
+
+  return(true);
+}
+
+// No character is on the keyboards twice
+constexpr bool tvkCharactersUnique()
+{
+  for(int a = 0; a < 150; a++)
+  {
+    const TVKKeyDescriptor &ka = (a < 75) ? tvkKeys[a] : tvkShiftedKeys[a-75];
+    if(ka.kind != TVKKeyDescriptor::Character) continue;
+
+    for(int b = a+1; b < 150; b++)
+    {
+      const TVKKeyDescriptor &kb = (b < 75) ? tvkKeys[b] : tvkShiftedKeys[b-75];
+      if(ka.unicode == kb.unicode) return(false);
+    }
+  }
+
+  return(true);
+}
+
+static_assert(tvkActionKeysPlaced(tvkKeys), "action keys out of place on the keyboard");
+static_assert(tvkActionKeysPlaced(tvkShiftedKeys), "action keys out of place on the shift keyboard");
+static_assert(tvkCharactersValid(tvkKeys), "bad character on the keyboard");
+static_assert(tvkCharactersValid(tvkShiftedKeys), "bad character on the shift keyboard");
+static_assert(tvkCharactersUnique(), "character on the keyboards twice");
+static_assert((tvkTIS620(u'\x0e01') == 161) && (tvkTIS620(u'a') == 'a') && (tvkTIS620(u'\x0e3b') == -1), "TIS-620 rule");
+static_assert(tvkKeys[7].nsm && !tvkKeys[8].nsm && (tvkKeys[7].unicode == 0x0e36), "NSM rule");
+static_assert((tvkUnicodeText[161] == 0x0e01) && (tvkUtf8Text[161].length == 3) && (tvkUtf8Text[161].bytes[0] == '\xe0') &&
+              (tvkUtf8Text[161].bytes[1] == '\xb8') && (tvkUtf8Text[161].bytes[2] == '\x81') &&
+              (tvkUtf8Text[8].length == 1) && (tvkUtf8Text[8].bytes[0] == '\b'), "UTF-8 rule");
+
+#endif  // TVKKeyTable_h
@@ -0,0 +1,121 @@
+/**
+ * @file   TVKLayerCache.cc
+ * @brief  Keyboard images shared by every keyboard in the process
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKLayerCache.h"
+
+#include <QHash>
+#include <QString>
+#include <QWeakPointer>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <string.h>
+
+// Keyboards stay alive only while a keyboard is holding them
+static QHash<QString, QWeakPointer<const TVKLayer> > layers;
+static QMutex mutex;
+
+// Key for a spec, equal specs have equal keys
+static QString specKey(const TVKLayerSpec &spec)
+{
+  // A layout stays alive while a keyboard drawn from it does, so its address is not reused
+  return(QString("%1x%2/%3/%4/%5/%6/%7:%8/%9/%10").arg(spec.size.width()).arg(spec.size.height()).arg(spec.ratio)
+         .arg(spec.fontName).arg(spec.fontSize).arg(spec.addSpaceNSM ? 1 : 0)
+         .arg((quintptr)spec.layout.data(), 0, 16).arg(spec.layer).arg(spec.actionKeySize)
+         .arg(spec.grayscale ? 8 : 32));
+}
+
+// Find a keyboard drawn for a spec
+QSharedPointer<const TVKLayer> TVKLayerCache::find(const TVKLayerSpec &spec)
+{
+  QMutexLocker locker(&mutex);
+
+  return(layers.value(specKey(spec)).toStrongRef());
+}
+
+// Share a keyboard that has been drawn
+QSharedPointer<const TVKLayer> TVKLayerCache::insert(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed)
+{
+  QMutexLocker locker(&mutex);
+
+  QString key = specKey(spec);
+
+  QSharedPointer<const TVKLayer> found = layers.value(key).toStrongRef();
+  if(!found.isNull())
+    return(found);
+
+  // Forget keyboards nobody holds any more
+  QHash<QString, QWeakPointer<const TVKLayer> >::iterator it = layers.begin();
+  while(it != layers.end())
+  {
+    if(it.value().isNull())
+      it = layers.erase(it);
+    else
+      ++it;
+  }
+
+  TVKLayer *layer = new TVKLayer;
+  layer->spec     = spec;
+  layer->keyboard = keyboard;
+  layer->pressed  = pressed;
+
+  found = QSharedPointer<const TVKLayer>(layer);
+  layers.insert(key, found);
+
+  return(found);
+}
+
+// A copy of a keyboard with only the image, compressed. Keyboards are mostly long runs of white
+// so the fastest level compresses them well
+QSharedPointer<const TVKLayer> TVKLayerCache::compress(const TVKLayer &layer)
+{
+  TVKLayer *packed   = new TVKLayer;
+  packed->spec       = layer.spec;
+  packed->compressed = qCompress(layer.keyboard.constBits(), layer.keyboard.sizeInBytes(), 1);
+
+  return(QSharedPointer<const TVKLayer>(packed));
+}
+
+// Share a compressed keyboard, the pressed keys are made again from the image
+QSharedPointer<const TVKLayer> TVKLayerCache::expand(const TVKLayer &layer)
+{
+  // Another keyboard may be holding it already
+  QSharedPointer<const TVKLayer> found = find(layer.spec);
+  if(!found.isNull())
+    return(found);
+
+  const TVKLayerSpec &spec = layer.spec;
+  QByteArray bits = qUncompress(layer.compressed);
+
+  // The image is the size and format it was drawn with
+  QImage keyboard(spec.size*spec.ratio, spec.grayscale ? QImage::Format_Grayscale8 : QImage::Format_RGB32);
+  if(bits.size() != keyboard.sizeInBytes())
+    return(QSharedPointer<const TVKLayer>());
+
+  memcpy(keyboard.bits(), bits.constData(), bits.size());
+  keyboard.setDevicePixelRatio(spec.ratio);
+
+  QImage pressed = keyboard;
+  pressed.invertPixels();
+
+  return(insert(spec, keyboard, pressed));
+}
@@ -0,0 +1,65 @@
+/**
+ * @file   TVKLayerCache.h
+ * @brief  Keyboard images shared by every keyboard in the process
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKLayerCache_h
+#define TVKLayerCache_h
+
+#include <QImage>
+#include <QByteArray>
+#include <QSharedPointer>
+
+#include "TVKLayerRenderer.h"
+
+/// @struct A keyboard that has been drawn
+struct TVKLayer
+{
+  /// What it was drawn with
+  TVKLayerSpec spec;
+
+  /// Image of the keyboard
+  QImage keyboard;
+
+  /// Pressed images of every key
+  QImage pressed;
+
+  /// Image of the keyboard compressed by TVKLayerCache::compress, the images are null then
+  QByteArray compressed;
+};
+
+/// @class Drawn keyboards, shared by every keyboard in the process while any of them holds one
+class TVKLayerCache
+{
+public:
+  /// Find a keyboard drawn for a spec, null if no keyboard holds one
+  static QSharedPointer<const TVKLayer> find(const TVKLayerSpec &spec);
+
+  /// Share a keyboard that has been drawn, returns the one already shared if there is one
+  static QSharedPointer<const TVKLayer> insert(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed);
+
+  /// A copy of a keyboard with only the image, compressed. It is not shared
+  static QSharedPointer<const TVKLayer> compress(const TVKLayer &layer);
+
+  /// Share a compressed keyboard, null if it cannot be expanded
+  static QSharedPointer<const TVKLayer> expand(const TVKLayer &layer);
+};
+
+#endif  // TVKLayerCache_h
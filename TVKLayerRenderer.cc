@@ -0,0 +1,232 @@
+/**
+ * @file   TVKLayerRenderer.cc
+ * @brief  Draws keyboard images, on any thread
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKLayerRenderer.h"
+#include "TVKGlyphAtlas.h"
+#include "TVKKeyGeometry.h"
+#include "TVKInstrumentation.h"
+#include "TVKLayout.h"
+
+#include <QPainter>
+#include <QColor>
+#include <QFont>
+#include <QFontMetrics>
+#include <QSharedPointer>
+
+#include "Multisize/actionkeys.h"
+
+// Format of the keyboard, in standard keys
+static const int columns = 15;
+static const int rows    = 5;
+
+// Action key images, in the same order as actionkeys.h
+enum ActionKey { Backspace, Tab, Enter, Shift, Font };
+
+// Get an action key image, size is 0 = small, 1 = medium, 2 = large.
+// The image uses the pixels compiled into the program, nothing is decoded or copied
+static QImage actionKey(ActionKey which, int size)
+{
+  if((size < 0) || (size > 2)) size = 1;
+
+  return(QImage((const uchar *)actionkeys[which][size].pixels, actionkeys[which][size].width,
+                actionkeys[which][size].height, actionkeys[which][size].width*4, QImage::Format_RGB32));
+}
+
+// Draw a keyboard and its pressed keys
+QImage TVKLayerRenderer::render(const TVKLayerSpec &spec, QImage *pressed)
+{
+  TVKScopedTimer timing(TVKInstrumentation::Rasterize);
+
+  QSharedPointer<const TVKLayout> layout = spec.layout.isNull() ? TVKLayouts::standard() : spec.layout;
+  const std::array<TVKKeyDescriptor, 75> &keymap = layout->layers.at(spec.layer).keys;
+  int a;
+
+  TVKKeyGeometry keyGeometry;
+  keyGeometry.setSize(spec.size.width(), spec.size.height());
+
+  QImage keyboard(spec.size*spec.ratio, QImage::Format_RGB32);
+  keyboard.setDevicePixelRatio(spec.ratio);
+  keyboard.fill(QColor(255,255,255));
+
+  QPainter mypaint(&keyboard);
+  mypaint.setPen(QColor(0,0,0));
+
+  // Draw grid
+  mypaint.drawLines(keyGeometry.gridLines());
+
+  // Fill in unused areas
+  for(a = 0; a < keyGeometry.unusedAreas().size(); a++)
+    mypaint.fillRect(keyGeometry.unusedAreas().at(a), QColor(64,64,64));
+
+  // Draw keycaps and action keys
+
+  QSharedPointer<TVKGlyphAtlas> glyphs = TVKGlyphAtlas::atlas(spec.fontName, spec.fontSize, spec.ratio,
+                                                              spec.addSpaceNSM, TVKLayouts::keycaps(spec.addSpaceNSM));
+  QImage action;
+
+  for(a = 0; a < keyGeometry.count(); a++)
+  {
+    const TVKKey &key = keyGeometry.key(a);
+    const TVKKeyDescriptor &d = keymap[key.row*columns+key.column];
+
+    switch(d.kind)
+    {
+      case TVKKeyDescriptor::Character:
+      glyphs->drawKeycap(&mypaint, key.area, d.keycap(spec.addSpaceNSM));
+      continue;
+
+      case TVKKeyDescriptor::Shift:
+      action = actionKey(Shift, spec.actionKeySize);
+
+      // Highlight shift keys on every layer but the first
+      if(spec.layer > 0)
+      {
+        action.invertPixels();
+        mypaint.fillRect(key.area, QColor(0,0,0));
+      }
+      break;
+
+      case TVKKeyDescriptor::Font:      action = actionKey(Font, spec.actionKeySize);      break;
+      case TVKKeyDescriptor::Backspace: action = actionKey(Backspace, spec.actionKeySize); break;
+      case TVKKeyDescriptor::Tab:       action = actionKey(Tab, spec.actionKeySize);       break;
+      case TVKKeyDescriptor::Enter:     action = actionKey(Enter, spec.actionKeySize);     break;
+
+      default: // space
+      continue;
+    }
+
+    mypaint.drawImage(key.centre.x()-action.width()/2, key.centre.y()-action.height()/2, action);
+  }
+
+  mypaint.end();
+
+  // The keyboard is black and white with grey only at the edges of glyphs, 8 bits are enough
+  if(spec.grayscale)
+    keyboard = keyboard.convertToFormat(QImage::Format_Grayscale8);
+
+  // Every pressed key is the inverse of the keyboard so make the sprites now,
+  // showing a key press is then a copy of part of this image
+  if(pressed != NULL)
+  {
+    *pressed = keyboard;
+    pressed->invertPixels();
+  }
+
+  return(keyboard);
+}
+
+// Draw a keyboard and send it back
+void TVKLayerRenderer::renderLayer(const TVKLayerSpec &spec)
+{
+  QImage pressed;
+  QImage keyboard = render(spec, &pressed);
+
+  emit layerRendered(spec, keyboard, pressed);
+}
+
+// Measure every font size in a range and send them back
+void TVKLayerRenderer::measureLadder(const QString &fontName, bool addSpaceNSM, int smallest, int largest)
+{
+  QList<TVKSizeStep> ladder;
+
+  for(int size = smallest; size <= largest; size++)
+    ladder.append(measure(fontName, size, addSpaceNSM));
+
+  emit ladderMeasured(fontName, addSpaceNSM, ladder);
+}
+
+// Measure the keyboard for a font, the widest and highest glyphs decide the size of a key
+TVKSizeStep TVKLayerRenderer::measure(const QString &fontName, int fontSize, bool addSpaceNSM)
+{
+  TVKScopedTimer timing(TVKInstrumentation::FontMetrics);
+
+  int border = 2;
+  int glyph_width, glyph_height;
+  int khomut   = 0x0e5b;
+  int nine     = 0x0e59;
+  int ying     = 0x0e0d;
+  int jula     = 0x0e2c;
+  int am       = 0x0e33;
+  int maimalai = 0x0e44;
+
+  TVKSizeStep step;
+  step.fontSize = fontSize;
+
+  QChar testwide = QChar(khomut);
+  QString testhigh;
+
+  testhigh.append(QChar(0x0e44));
+  testhigh.append(QChar(0x0e1b));
+  testhigh.append(QChar(0x0e26));
+  testhigh.append(QChar(0x0e21));
+  testhigh.append(QChar(0x0e35));
+  testhigh.append(QChar(0x0e49));
+  testhigh.append(QChar(0x0e1a));
+  testhigh.append(QChar(0x0e39));
+
+  QFont f(fontName, fontSize);
+  QFontMetrics fm(f);
+  glyph_height = fm.boundingRect(testhigh).height();
+
+  // Test several characters to find widest
+  QString testam;
+  if(addSpaceNSM)
+    testam.append(QChar(0x25cc));
+  testam.append(QChar(am));
+
+  glyph_width  = fm.boundingRect(testwide).width();
+
+  int test_glyph_width = fm.boundingRect(QChar(nine)).width();
+  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+
+  test_glyph_width = fm.boundingRect(QChar(ying)).width();
+  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+
+  test_glyph_width = fm.boundingRect(QChar(jula)).width();
+  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+
+  test_glyph_width = fm.boundingRect(testam).width();
+  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+
+  test_glyph_width = fm.boundingRect(QChar(maimalai)).width();
+  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+
+  if((glyph_width > 36) && (glyph_height > 36))
+  {
+    border = 8;
+    step.actionKeySize = 2;
+  }
+  else if((glyph_width > 20) && (glyph_height > 20))
+  {
+    border = 4;
+    step.actionKeySize = 1;
+  }
+  else
+  {
+    border = 2;
+    step.actionKeySize = 0;
+  }
+
+  step.minimumSize = QSize(glyph_width*columns + border*columns*2, glyph_height*rows + border*rows*2);
+
+  return(step);
+}
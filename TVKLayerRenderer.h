@@ -0,0 +1,129 @@
+/**
+ * @file   TVKLayerRenderer.h
+ * @brief  Draws keyboard images, on any thread
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKLayerRenderer_h
+#define TVKLayerRenderer_h
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSharedPointer>
+#include <QMetaType>
+
+#include "TVKLayout.h"
+
+/// @struct Everything needed to draw one keyboard
+struct TVKLayerSpec
+{
+  /// Constructor
+  TVKLayerSpec() : ratio(1.0), fontSize(0), addSpaceNSM(true), layer(0), actionKeySize(0), grayscale(false) { }
+
+  /// Size of the widget
+  QSize size;
+
+  /// Device pixel ratio
+  qreal ratio;
+
+  /// Name of font
+  QString fontName;
+
+  /// Size of font
+  int fontSize;
+
+  /// Add a spacing character for NSM
+  bool addSpaceNSM;
+
+  /// Layout, null for the standard layout
+  QSharedPointer<const TVKLayout> layout;
+
+  /// Layer of the layout
+  int layer;
+
+  /// Size of action keys: 0 = small, 1 = medium, 2 = large
+  int actionKeySize;
+
+  /// Images are 8-bit grey rather than 32-bit colour
+  bool grayscale;
+
+  /// Images drawn from equal specs are identical
+  bool operator==(const TVKLayerSpec &s) const
+  {
+    return((size == s.size) && (ratio == s.ratio) && (fontName == s.fontName) && (fontSize == s.fontSize) &&
+           (addSpaceNSM == s.addSpaceNSM) && (layout == s.layout) && (layer == s.layer) &&
+           (actionKeySize == s.actionKeySize) && (grayscale == s.grayscale));
+  }
+
+  /// Images drawn from different specs differ
+  bool operator!=(const TVKLayerSpec &s) const { return(!(*this == s)); }
+};
+
+Q_DECLARE_METATYPE(TVKLayerSpec)
+
+/// @struct Keyboard size for one font size, a step on the zoom ladder
+struct TVKSizeStep
+{
+  /// Constructor
+  TVKSizeStep() : fontSize(0), actionKeySize(0) { }
+
+  /// Size of font
+  int fontSize;
+
+  /// Smallest keyboard that fits the keycaps
+  QSize minimumSize;
+
+  /// Size of action keys: 0 = small, 1 = medium, 2 = large
+  int actionKeySize;
+};
+
+Q_DECLARE_METATYPE(TVKSizeStep)
+
+/// @class Draws keyboards, lives on a worker thread
+class TVKLayerRenderer : public QObject
+{
+  Q_OBJECT
+
+public:
+  /// Draw a keyboard and its pressed keys, safe to call from any thread
+  static QImage render(const TVKLayerSpec &spec, QImage *pressed);
+
+  /// Measure the keyboard for a font, safe to call from any thread
+  static TVKSizeStep measure(const QString &fontName, int fontSize, bool addSpaceNSM);
+
+public slots:
+  /// Draw a keyboard and send it back
+  void renderLayer(const TVKLayerSpec &spec);
+
+  /// Measure every font size in a range and send them back
+  void measureLadder(const QString &fontName, bool addSpaceNSM, int smallest, int largest);
+
+signals:
+  /// A keyboard has been drawn
+  void layerRendered(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed);
+
+  /// Sizes have been measured, starting at the smallest font size
+  void ladderMeasured(const QString &fontName, bool addSpaceNSM, const QList<TVKSizeStep> &ladder);
+};
+
+#endif  // TVKLayerRenderer_h
@@ -0,0 +1,311 @@
+/**
+ * @file   TVKLayout.cc
+ * @brief  Keyboard layouts, each with any number of layers
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKLayout.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonParseError>
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+
+const int TVKLayouts::maximumLayers;
+
+// Layouts, built-in layouts first. Keyboards are drawn on worker threads too
+static QList<QSharedPointer<const TVKLayout> > layouts;
+static QMutex mutex;
+
+// Layer of Thai digits and symbols, shared by the Thai layouts
+static const char *thaiSymbols = R"({
+  "name": "Symbols", "latched": true,
+  "rows": [ "๑๒๓๔๕๖๗๘๙๐฿๏๛", "๚ฯๆฺํ๎ๅ!@#$&", "()[]{}<>*+=", ";-_/\\|~^'\":" ]
+})";
+
+// Built-in layouts, in the format taken by TVKLayouts::load(), and whether the Thai symbols are added.
+// Kedmanee comes from the tables in TVKKeyTable.h
+static const struct { const char *definition; bool thai; } builtInLayouts[] = {
+  { R"({
+  "name": "Pattachote",
+  "layers": [
+    { "name": "Normal", "rows": [ "_=๒๓๔๕ู๗๘๙๐๑๖", "็ตยอร่ดมวแใฌ", "้ทงกัีานเไข", "ฃบปลหิคสะจพ" ] },
+    { "name": "Shift",  "rows": [ "฿+\"/,?ุ_.()-%", "๊ฤๆญษึฝซถฒฯฦ", "๋ธำณ์ืผชโฆฑ", "ฅฎฏฐภัศฮฟฉฬ" ] }
+  ]
+})", true },
+  { R"({
+  "name": "Latin",
+  "layers": [
+    { "name": "Normal", "rows": [ "`1234567890-=", "qwertyuiop[]", "asdfghjkl;'", "\\zxcvbnm,./" ] },
+    { "name": "Shift",  "rows": [ "~!@#$%^&*()_+", "QWERTYUIOP{}", "ASDFGHJKL:\"", "|ZXCVBNM<>?" ] }
+  ]
+})", false } };
+
+// Character keys on each row of the key geometry, the rest are action keys. Rows start at the keys
+// of a physical keyboard: the key left of 1, Q, A and the key left of Z, which is backslash on ISO
+// keyboards. The position left of A has no physical key and only Kedmanee puts a key there
+static const int rowFirstColumn[4] = {  0,  1,  2,  1 };
+static const int rowKeys[4]        = { 13, 12, 11, 11 };
+
+// Read a layer from its JSON definition. A space is a position without a key
+static bool parseLayer(const QJsonObject &definition, TVKLayoutLayer *layer, QString *error)
+{
+  layer->name    = definition.value("name").toString();
+  layer->latched = definition.value("latched").toBool(false);
+
+  // Action keys stay where the key geometry puts them
+  for(int k = 0; k < 75; k++)
+    layer->keys[k] = (tvkKeys[k].kind == TVKKeyDescriptor::Character) ? tvkDescribe(0) : tvkKeys[k];
+
+  QJsonArray rows = definition.value("rows").toArray();
+  if(rows.size() != 4)
+  {
+    *error = QString("layer \"%1\" needs 4 rows").arg(layer->name);
+    return(false);
+  }
+
+  for(int row = 0; row < 4; row++)
+  {
+    QString keys = rows.at(row).toString();
+    if(keys.size() > rowKeys[row])
+    {
+      *error = QString("row %1 of layer \"%2\" has more than %3 keys").arg(row+1).arg(layer->name).arg(rowKeys[row]);
+      return(false);
+    }
+
+    for(int a = 0; a < keys.size(); a++)
+    {
+      if(keys.at(a) == QChar(' '))
+        continue;
+
+      int value = tvkTIS620(keys.at(a).unicode());
+      if(value == -1)
+      {
+        *error = QString("U+%1 in layer \"%2\" is not in TIS-620").arg((int)keys.at(a).unicode(), 4, 16, QChar('0'))
+                 .arg(layer->name);
+        return(false);
+      }
+
+      layer->keys[row*15 + rowFirstColumn[row] + a] = tvkDescribe(value);
+    }
+  }
+
+  return(true);
+}
+
+// Read a layout from its JSON definition
+static bool parseLayout(const QByteArray &json, TVKLayout *layout, QString *error)
+{
+  QJsonParseError parseError;
+  QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+
+  if(!document.isObject())
+  {
+    *error = parseError.errorString();
+    return(false);
+  }
+
+  QJsonObject definition = document.object();
+
+  layout->name = definition.value("name").toString();
+  if(layout->name.isEmpty())
+  {
+    *error = "layout has no name";
+    return(false);
+  }
+
+  QJsonArray layers = definition.value("layers").toArray();
+  if(layers.isEmpty() || (layers.size() > TVKLayouts::maximumLayers))
+  {
+    *error = QString("layout \"%1\" needs 1 to %2 layers").arg(layout->name).arg(TVKLayouts::maximumLayers);
+    return(false);
+  }
+
+  for(int a = 0; a < layers.size(); a++)
+  {
+    TVKLayoutLayer layer;
+    if(!parseLayer(layers.at(a).toObject(), &layer, error))
+      return(false);
+
+    layout->layers.append(layer);
+  }
+
+  return(true);
+}
+
+// Add the built-in layouts the first time they are needed, the mutex is held
+static void addBuiltIn()
+{
+  if(!layouts.isEmpty())
+    return;
+
+  QString error;
+
+  TVKLayoutLayer symbols;
+  parseLayer(QJsonDocument::fromJson(thaiSymbols).object(), &symbols, &error);
+
+  TVKLayout *kedmanee = new TVKLayout;
+  kedmanee->name = "Kedmanee";
+
+  TVKLayoutLayer layer;
+  layer.name = "Normal";
+  layer.keys = tvkKeys;
+  kedmanee->layers.append(layer);
+
+  layer.name = "Shift";
+  layer.keys = tvkShiftedKeys;
+  kedmanee->layers.append(layer);
+
+  kedmanee->layers.append(symbols);
+  layouts.append(QSharedPointer<const TVKLayout>(kedmanee));
+
+  for(const auto &builtIn : builtInLayouts)
+  {
+    TVKLayout *layout = new TVKLayout;
+    parseLayout(builtIn.definition, layout, &error);
+
+    // Thai layouts share the symbols
+    if(builtIn.thai == true)
+      layout->layers.append(symbols);
+
+    layouts.append(QSharedPointer<const TVKLayout>(layout));
+  }
+}
+
+// Names of the layouts
+QStringList TVKLayouts::names()
+{
+  QMutexLocker locker(&mutex);
+  addBuiltIn();
+
+  QStringList list;
+  for(int a = 0; a < layouts.size(); a++)
+    list.append(layouts.at(a)->name);
+
+  return(list);
+}
+
+// Find a layout by name
+QSharedPointer<const TVKLayout> TVKLayouts::find(const QString &name)
+{
+  QMutexLocker locker(&mutex);
+  addBuiltIn();
+
+  for(int a = 0; a < layouts.size(); a++)
+  {
+    if(layouts.at(a)->name == name)
+      return(layouts.at(a));
+  }
+
+  return(QSharedPointer<const TVKLayout>());
+}
+
+// The layout used when none is chosen
+QSharedPointer<const TVKLayout> TVKLayouts::standard()
+{
+  QMutexLocker locker(&mutex);
+  addBuiltIn();
+
+  return(layouts.first());
+}
+
+// Add a layout from its JSON definition. Keyboards showing a layout it replaces keep the old one until
+// they change layout
+bool TVKLayouts::load(const QByteArray &json, QString *error)
+{
+  QString message;
+  TVKLayout *layout = new TVKLayout;
+
+  if(!parseLayout(json, layout, &message))
+  {
+    delete layout;
+    if(error != NULL) *error = message;
+    return(false);
+  }
+
+  QMutexLocker locker(&mutex);
+  addBuiltIn();
+
+  QSharedPointer<const TVKLayout> shared(layout);
+
+  for(int a = 0; a < layouts.size(); a++)
+  {
+    if(layouts.at(a)->name == layout->name)
+    {
+      layouts.replace(a, shared);
+      return(true);
+    }
+  }
+
+  layouts.append(shared);
+
+  return(true);
+}
+
+// Add a layout from a JSON file
+bool TVKLayouts::loadFile(const QString &filename, QString *error)
+{
+  QFile file(filename);
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    if(error != NULL) *error = file.errorString();
+    return(false);
+  }
+
+  return(load(file.readAll(), error));
+}
+
+// Every keycap on every layout. Keycaps of layouts added after a font's atlas was made are drawn
+// without the atlas
+QStringList TVKLayouts::keycaps(bool addSpaceNSM)
+{
+  QMutexLocker locker(&mutex);
+  addBuiltIn();
+
+  QSet<QString> found;
+  QStringList caps;
+
+  for(int a = 0; a < layouts.size(); a++)
+  {
+    for(int b = 0; b < layouts.at(a)->layers.size(); b++)
+    {
+      const std::array<TVKKeyDescriptor, 75> &keys = layouts.at(a)->layers.at(b).keys;
+
+      for(int k = 0; k < 75; k++)
+      {
+        if(keys[k].kind != TVKKeyDescriptor::Character)
+          continue;
+
+        QString cap = keys[k].keycap(addSpaceNSM).toString();
+        if(!found.contains(cap))
+        {
+          found.insert(cap);
+          caps.append(cap);
+        }
+      }
+    }
+  }
+
+  return(caps);
+}
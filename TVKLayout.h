@@ -0,0 +1,91 @@
+/**
+ * @file   TVKLayout.h
+ * @brief  Keyboard layouts, each with any number of layers
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKLayout_h
+#define TVKLayout_h
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QSharedPointer>
+
+#include <array>
+
+#include "TVKKeyTable.h"
+
+/// @struct One layer of a layout, e.g. the shift keys
+struct TVKLayoutLayer
+{
+  /// Constructor
+  TVKLayoutLayer() : latched(false) { }
+
+  /// Name of the layer
+  QString name;
+
+  /// The layer stays until shift is pressed, otherwise any other key goes back to the first layer
+  bool latched;
+
+  /// Keys of the layer, by row*15 + column
+  std::array<TVKKeyDescriptor, 75> keys;
+
+  /// Key at a keymap position
+  const TVKKeyDescriptor &key(int row, int column) const { return(keys[row*15 + column]); }
+};
+
+/// @struct A keyboard layout, shift steps through its layers. Layouts are not changed once made
+struct TVKLayout
+{
+  /// Name of the layout
+  QString name;
+
+  /// Layers, the first is shown when nothing is shifted
+  QList<TVKLayoutLayer> layers;
+};
+
+/// @class Keyboard layouts, shared by every keyboard in the process
+class TVKLayouts
+{
+public:
+  /// Most layers a layout may have
+  static const int maximumLayers = 16;
+
+  /// Names of the layouts, the built-in layouts first
+  static QStringList names();
+
+  /// Find a layout by name, null if there is none
+  static QSharedPointer<const TVKLayout> find(const QString &name);
+
+  /// The layout used when none is chosen, Kedmanee
+  static QSharedPointer<const TVKLayout> standard();
+
+  /// Add a layout from its JSON definition, replacing a layout with the same name. False if it is not valid
+  static bool load(const QByteArray &json, QString *error = NULL);
+
+  /// Add a layout from a JSON file
+  static bool loadFile(const QString &filename, QString *error = NULL);
+
+  /// Every keycap on every layout, used to fill the glyph atlas
+  static QStringList keycaps(bool addSpaceNSM);
+};
+
+#endif  // TVKLayout_h
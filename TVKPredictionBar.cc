@@ -0,0 +1,155 @@
+/**
+ * @file   TVKPredictionBar.cc
+ * @brief  Row of suggested words above the keyboard
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKPredictionBar.h"
+
+#include <QPainter>
+#include <QFontMetrics>
+#include <QMouseEvent>
+#include <QTouchEvent>
+
+const int TVKPredictionBar::cells;
+
+// Height needed for a font, with the same border as the keys
+static int measureHeight(const QFont &font)
+{
+  QFontMetrics fm(font);
+
+  return(fm.height() + 8);
+}
+
+// Constructor
+TVKPredictionBar::TVKPredictionBar(QWidget *parent) : QWidget(parent)
+{
+  setAttribute(Qt::WA_OpaquePaintEvent);
+
+  // Touches are taken here, otherwise the keyboard takes them and no mouse events are made
+  setAttribute(Qt::WA_AcceptTouchEvents);
+
+  wordHeight = measureHeight(wordFont);
+}
+
+// Show words
+void TVKPredictionBar::setSuggestions(const QStringList &newwords)
+{
+  QStringList shown = newwords.mid(0, cells);
+
+  // Typing usually leaves the row empty, nothing to repaint then
+  if(shown == words)
+    return;
+
+  words = shown;
+  update();
+}
+
+// Font the words are drawn in. The height is measured now, as the keyboard asks for it on every
+// press and paint
+void TVKPredictionBar::setWordFont(const QString &family, int size)
+{
+  wordFont   = QFont(family, size);
+  wordHeight = measureHeight(wordFont);
+  update();
+}
+
+// Area of a cell, inside the grid lines
+QRect TVKPredictionBar::cellArea(int cell) const
+{
+  int left  = width()*cell/cells;
+  int right = width()*(cell+1)/cells;
+
+  return(QRect(QPoint(left+1, 1), QPoint(right-1, height()-2)));
+}
+
+// Choose the word under the mouse
+void TVKPredictionBar::mousePressEvent(QMouseEvent *e)
+{
+  if(e->button() != Qt::LeftButton) return;
+
+  chooseAt(e->position(), e->timestamp());
+}
+
+// Choose the word under each touch point pressed, every touch is accepted
+bool TVKPredictionBar::event(QEvent *e)
+{
+  switch(e->type())
+  {
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    {
+      QTouchEvent *t = static_cast<QTouchEvent *>(e);
+      const QList<QEventPoint> &points = t->points();
+
+      for(int a = 0; a < points.size(); a++)
+      {
+        if(points.at(a).state() == QEventPoint::Pressed)
+          chooseAt(points.at(a).position(), t->timestamp());
+      }
+      return(true);
+    }
+
+    case QEvent::TouchCancel:
+      return(true);
+
+    default:
+      break;
+  }
+
+  return(QWidget::event(e));
+}
+
+// Choose the word at a position
+void TVKPredictionBar::chooseAt(const QPointF &position, quint64 timestamp)
+{
+  int cell = (int)(position.x())*cells/width();
+
+  if((cell >= 0) && (cell < words.size()))
+    emit suggestionChosen(cell, timestamp);
+}
+
+// Paint the words
+void TVKPredictionBar::paintEvent(QPaintEvent *)
+{
+  QPainter qp(this);
+
+  qp.fillRect(rect(), QColor(255,255,255));
+  qp.setPen(QColor(0,0,0));
+
+  // Outline and cells, the keyboard draws the line below
+  qp.drawLine(0, 0, width()-1, 0);
+  qp.drawLine(0, 0, 0, height()-1);
+  qp.drawLine(width()-1, 0, width()-1, height()-1);
+
+  for(int cell = 1; cell < cells; cell++)
+    qp.drawLine(width()*cell/cells, 0, width()*cell/cells, height()-1);
+
+  qp.setFont(wordFont);
+  QFontMetrics fm(wordFont);
+
+  for(int cell = 0; cell < words.size(); cell++)
+  {
+    QRect area = cellArea(cell);
+    qp.drawText(area, Qt::AlignCenter, fm.elidedText(words.at(cell), Qt::ElideRight, area.width()));
+  }
+
+  qp.end();
+}
@@ -0,0 +1,86 @@
+/**
+ * @file   TVKPredictionBar.h
+ * @brief  Row of suggested words above the keyboard
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKPredictionBar_h
+#define TVKPredictionBar_h
+
+#include <QWidget>
+#include <QFont>
+#include <QString>
+#include <QStringList>
+
+/// @class Row of suggested words, one cell for each
+class TVKPredictionBar : public QWidget
+{
+  Q_OBJECT
+
+public:
+  /// Number of cells
+  static const int cells = 5;
+
+  /// Constructor
+  TVKPredictionBar(QWidget *parent = NULL);
+
+  /// Show words, as many as there are cells
+  void setSuggestions(const QStringList &words);
+
+  /// Words shown
+  const QStringList &suggestions() const { return(words); }
+
+  /// Font the words are drawn in
+  void setWordFont(const QString &family, int size);
+
+  /// Height needed for the font, measured when the font is set
+  int barHeight() const { return(wordHeight); }
+
+signals:
+  /// A word was pressed, timestamp is from the mouse or touch event
+  void suggestionChosen(int index, quint64 timestamp);
+
+protected:
+  /// Choose the word under the mouse
+  void mousePressEvent(QMouseEvent *e);
+
+  /// Choose the word under each touch point pressed
+  bool event(QEvent *e);
+
+  /// Paint the words
+  void paintEvent(QPaintEvent *);
+
+private:
+  /// Area of a cell
+  QRect cellArea(int cell) const;
+
+  /// Choose the word at a position
+  void chooseAt(const QPointF &position, quint64 timestamp);
+
+  /// Words shown
+  QStringList words;
+
+  /// Font the words are drawn in
+  QFont wordFont;
+
+  /// Height needed for wordFont
+  int wordHeight;
+};
+
+#endif  // TVKPredictionBar_h
@@ -0,0 +1,651 @@
+/**
+ * @file   TVKQuickKeyboard.cc
+ * @brief  Thai Virtual Keyboard as a Qt Quick item, drawn from scene graph textures
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKQuickKeyboard.h"
+#include "TVKGlyphAtlas.h"
+#include "TVKFontIndex.h"
+#include "TVKKeyTable.h"
+
+#include <QQuickWindow>
+#include <QSGImageNode>
+#include <QSGTexture>
+#include <QMouseEvent>
+#include <QTouchEvent>
+#include <QThread>
+#include <QTimer>
+
+#include <math.h>
+
+// Press made by the mouse rather than a touch point
+static const int mousePress = -1;
+
+// Time without a resize before the keyboard is drawn at the new size, ms
+static const int resizeQuietPeriod = 100;
+
+/// @class Scene graph of the keyboard: the current layer and a node for each rectangle of a
+/// pressed key. It owns the textures, so they are freed on the render thread with it
+class TVKQuickNode : public QSGNode
+{
+public:
+  /// Constructor
+  TVKQuickNode(QQuickWindow *window);
+
+  /// Destructor
+  ~TVKQuickNode();
+
+  /// Upload the layers that changed since the last frame, each is uploaded once
+  void upload(const QList<QSharedPointer<const TVKLayer> > &layers);
+
+  /// Show a layer filling a rectangle
+  void showKeyboard(int layer, const QRectF &rect, bool stretched);
+
+  /// Show pressed keys from the pressed texture of a layer, rectangles are in logical pixels
+  void showPressed(int layer, const QList<QRect> &rects, qreal ratio);
+
+  /// Free textures replaced by upload, once no node uses them
+  void freeRetired();
+
+private:
+  /// Window making the textures and nodes
+  QQuickWindow *window;
+
+  /// The keyboard
+  QSGImageNode *keyboard;
+
+  /// Pressed key rectangles, reused from frame to frame
+  QList<QSGImageNode *> pressed;
+
+  /// Layers uploaded, by layer of the layout
+  QList<QSharedPointer<const TVKLayer> > uploaded;
+
+  /// Textures of the keyboards
+  QList<QSGTexture *> keyboardTextures;
+
+  /// Textures of the pressed keys
+  QList<QSGTexture *> pressedTextures;
+
+  /// Textures replaced by upload
+  QList<QSGTexture *> retired;
+};
+
+// Constructor
+TVKQuickNode::TVKQuickNode(QQuickWindow *window) : QSGNode()
+{
+  this->window = window;
+
+  keyboard = window->createImageNode();
+  keyboard->setOwnsTexture(false);
+  appendChildNode(keyboard);
+}
+
+// Destructor, the child nodes are deleted after this
+TVKQuickNode::~TVKQuickNode()
+{
+  qDeleteAll(keyboardTextures);
+  qDeleteAll(pressedTextures);
+  qDeleteAll(retired);
+}
+
+// Upload the layers that changed since the last frame
+void TVKQuickNode::upload(const QList<QSharedPointer<const TVKLayer> > &layers)
+{
+  // The layout may have changed
+  while(uploaded.size() > layers.size())
+  {
+    uploaded.removeLast();
+    retired.append(keyboardTextures.takeLast());
+    retired.append(pressedTextures.takeLast());
+  }
+
+  while(uploaded.size() < layers.size())
+  {
+    uploaded.append(QSharedPointer<const TVKLayer>());
+    keyboardTextures.append(NULL);
+    pressedTextures.append(NULL);
+  }
+
+  for(int l = 0; l < layers.size(); l++)
+  {
+    if(layers.at(l).isNull() || (layers.at(l) == uploaded.at(l)))
+      continue;
+
+    retired.append(keyboardTextures.at(l));
+    retired.append(pressedTextures.at(l));
+
+    uploaded[l]         = layers.at(l);
+    keyboardTextures[l] = window->createTextureFromImage(layers.at(l)->keyboard);
+    pressedTextures[l]  = window->createTextureFromImage(layers.at(l)->pressed);
+  }
+}
+
+// Show a layer filling a rectangle, smoothed when it is stretched
+void TVKQuickNode::showKeyboard(int layer, const QRectF &rect, bool stretched)
+{
+  QSGTexture *texture = keyboardTextures.at(layer);
+
+  if(keyboard->texture() != texture)
+    keyboard->setTexture(texture);
+
+  keyboard->setRect(rect);
+  keyboard->setSourceRect(QRectF(QPointF(0, 0), texture->textureSize()));
+  keyboard->setFiltering(stretched ? QSGTexture::Linear : QSGTexture::Nearest);
+}
+
+// Show pressed keys, only the rectangles of the nodes change from frame to frame
+void TVKQuickNode::showPressed(int layer, const QList<QRect> &rects, qreal ratio)
+{
+  QSGTexture *texture = pressedTextures.at(layer);
+
+  while(pressed.size() > rects.size())
+  {
+    QSGImageNode *node = pressed.takeLast();
+    removeChildNode(node);
+    delete node;
+  }
+
+  while(pressed.size() < rects.size())
+  {
+    QSGImageNode *node = window->createImageNode();
+    node->setOwnsTexture(false);
+    node->setTexture(texture);
+    node->setFiltering(QSGTexture::Nearest);
+
+    appendChildNode(node);
+    pressed.append(node);
+  }
+
+  for(int a = 0; a < rects.size(); a++)
+  {
+    const QRect &r = rects.at(a);
+    QSGImageNode *node = pressed.at(a);
+
+    if(node->texture() != texture)
+      node->setTexture(texture);
+
+    // Ratios such as 1.25 do not put every logical pixel on a whole device pixel
+    node->setRect(QRectF(r));
+    node->setSourceRect(QRectF(r.x()*ratio, r.y()*ratio, r.width()*ratio, r.height()*ratio));
+  }
+}
+
+// Free textures replaced by upload
+void TVKQuickNode::freeRetired()
+{
+  qDeleteAll(retired);
+  retired.clear();
+}
+
+// NSM get a dotted circle unless the font draws one, which only Mac fonts do
+static bool addsCircles(const QString &family)
+{
+#if __APPLE__
+  TVKFontInfo info;
+  return(!(TVKFontIndex::instance()->find(family, &info) && info.drawsCircles));
+#else
+  Q_UNUSED(family);
+  return(true);
+#endif
+}
+
+// Constructor
+TVKQuickKeyboard::TVKQuickKeyboard(QQuickItem *parent) : QQuickItem(parent)
+{
+  setFlag(ItemHasContents);
+  setAcceptedMouseButtons(Qt::LeftButton);
+
+  // Each finger presses keys of its own
+  setAcceptTouchEvents(true);
+
+  currentLayout = TVKLayouts::standard();
+  currentLayer  = 0;
+
+  tvkFontName   = "Arial";
+  tvkFontSize   = 24;
+  actionKeySize = 0;
+
+  // Layers that are not shown are drawn on a worker thread
+  qRegisterMetaType<TVKLayerSpec>("TVKLayerSpec");
+
+  renderThread = new QThread(this);
+  renderer     = new TVKLayerRenderer;
+  renderer->moveToThread(renderThread);
+
+  connect(renderThread, SIGNAL(finished()), renderer, SLOT(deleteLater()));
+  connect(renderer, SIGNAL(layerRendered(TVKLayerSpec,QImage,QImage)),
+          this, SLOT(keyboardRendered(TVKLayerSpec,QImage,QImage)));
+
+  renderThread->start();
+
+  // Wait for the size to settle before drawing after a resize
+  resizing = false;
+  resizeTimer = new QTimer(this);
+  resizeTimer->setSingleShot(true);
+  connect(resizeTimer, SIGNAL(timeout()), this, SLOT(finishResize()));
+
+  // Thai fonts are found in the background
+  TVKFontIndex::instance();
+
+  refreshFont();
+}
+
+// Destructor
+TVKQuickKeyboard::~TVKQuickKeyboard()
+{
+  // Stop drawing in the background
+  renderThread->quit();
+  renderThread->wait();
+}
+
+// Show a layout, the textures of its layers are uploaded as they are drawn
+bool TVKQuickKeyboard::setLayout(const QString &name)
+{
+  QSharedPointer<const TVKLayout> layout = TVKLayouts::find(name);
+  if(layout.isNull())
+    return(false);
+
+  if(layout == currentLayout)
+    return(true);
+
+  bool layerchanged = (currentLayer != 0);
+
+  currentLayout = layout;
+  currentLayer  = 0;
+
+  presses.clear();
+  layers.clear();
+  polish();
+
+  emit layoutChanged();
+  if(layerchanged)
+    emit layerChanged();
+
+  return(true);
+}
+
+// Set the font of the keycaps
+void TVKQuickKeyboard::setFontName(const QString &name)
+{
+  if(name == tvkFontName)
+    return;
+
+  tvkFontName = name;
+  refreshFont();
+
+  emit fontChanged();
+}
+
+// Set the size of the keycaps
+void TVKQuickKeyboard::setFontSize(int size)
+{
+  if(size == tvkFontSize)
+    return;
+
+  tvkFontSize = size;
+  refreshFont();
+
+  emit fontChanged();
+}
+
+// Check the order of Thai characters before sending them
+void TVKQuickKeyboard::setSequenceCheck(TVKSequenceCheck::Mode mode, bool correct)
+{
+  sequenceCheck.setMode(mode, correct);
+}
+
+// Measure the keyboard for the font, the layers are drawn again at the next polish
+void TVKQuickKeyboard::refreshFont()
+{
+  addSpaceNSM = addsCircles(tvkFontName);
+
+  TVKSizeStep step = TVKLayerRenderer::measure(tvkFontName, tvkFontSize, addSpaceNSM);
+
+  actionKeySize = step.actionKeySize;
+  setImplicitSize(step.minimumSize.width(), step.minimumSize.height());
+
+  polish();
+}
+
+// Everything needed to draw a layer at the current size and font
+TVKLayerSpec TVKQuickKeyboard::layerSpec(int layer) const
+{
+  TVKLayerSpec spec;
+
+  spec.size          = QSize((int)width(), (int)height());
+  spec.ratio         = (window() == NULL) ? 1.0 : window()->effectiveDevicePixelRatio();
+  spec.fontName      = tvkFontName;
+  spec.fontSize      = tvkFontSize;
+  spec.addSpaceNSM   = addSpaceNSM;
+  spec.layout        = currentLayout;
+  spec.layer         = layer;
+  spec.actionKeySize = actionKeySize;
+
+  return(spec);
+}
+
+// Draw the current layer now unless it is up to date, the others on the worker thread
+void TVKQuickKeyboard::drawKeyboard()
+{
+  if((window() == NULL) || (width() < 1) || (height() < 1))
+    return;
+
+  // Keys are laid out for the size of the item
+  keyGeometry.setSize((int)width(), (int)height());
+
+  while(layers.size() < currentLayout->layers.size())
+    layers.append(QSharedPointer<const TVKLayer>());
+
+  for(int l = 0; l < layers.size(); l++)
+  {
+    TVKLayerSpec spec = layerSpec(l);
+
+    if(!layers.at(l).isNull() && (layers.at(l)->spec == spec))
+      continue;
+
+    // Another keyboard may have drawn it already
+    QSharedPointer<const TVKLayer> layer = TVKLayerCache::find(spec);
+    if(!layer.isNull())
+    {
+      layers[l] = layer;
+      continue;
+    }
+
+    // Keep the glyphs for the worker thread too
+    glyphs = TVKGlyphAtlas::atlas(tvkFontName, tvkFontSize, spec.ratio, addSpaceNSM, TVKLayouts::keycaps(addSpaceNSM));
+
+    if(l == currentLayer)
+    {
+      QImage pressed;
+      QImage keyboard = TVKLayerRenderer::render(spec, &pressed);
+
+      layers[l] = TVKLayerCache::insert(spec, keyboard, pressed);
+    }
+    else if(!renderQueue.contains(spec))
+    {
+      renderQueue.append(spec);
+      QMetaObject::invokeMethod(renderer, "renderLayer", Qt::QueuedConnection, Q_ARG(TVKLayerSpec, spec));
+    }
+  }
+
+  update();
+}
+
+// A layer was drawn on the worker thread, it is uploaded with the next frame
+void TVKQuickKeyboard::keyboardRendered(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed)
+{
+  renderQueue.removeAll(spec);
+
+  QSharedPointer<const TVKLayer> layer = TVKLayerCache::insert(spec, keyboard, pressed);
+
+  // Use it if nothing changed while it was drawn
+  if((spec.layer < layers.size()) && (spec == layerSpec(spec.layer)))
+  {
+    layers[spec.layer] = layer;
+    update();
+  }
+}
+
+// Draw the current layer before the frame is synchronised
+void TVKQuickKeyboard::updatePolish()
+{
+  if(resizing == false)
+    drawKeyboard();
+}
+
+// The item was resized, stretch the last texture until the size settles
+void TVKQuickKeyboard::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+  QQuickItem::geometryChange(newGeometry, oldGeometry);
+
+  if(newGeometry.size() == oldGeometry.size())
+    return;
+
+  // Nothing to stretch yet
+  if((currentLayer >= layers.size()) || layers.at(currentLayer).isNull())
+  {
+    polish();
+    return;
+  }
+
+  resizing = true;
+  resizeTimer->start(resizeQuietPeriod);
+  update();
+}
+
+// Draw the keyboard at its final size
+void TVKQuickKeyboard::finishResize()
+{
+  resizeTimer->stop();
+  resizing = false;
+
+  drawKeyboard();
+}
+
+// Draw again when shown in a window, or moved to a screen with another device pixel ratio
+void TVKQuickKeyboard::itemChange(ItemChange change, const ItemChangeData &value)
+{
+  QQuickItem::itemChange(change, value);
+
+  if((change == ItemSceneChange) || (change == ItemDevicePixelRatioHasChanged))
+    polish();
+}
+
+// Upload new layers and move the pressed key nodes. The GUI thread is blocked meanwhile
+QSGNode *TVKQuickKeyboard::updatePaintNode(QSGNode *old, UpdatePaintNodeData *)
+{
+  TVKQuickNode *node = static_cast<TVKQuickNode *>(old);
+
+  // The layer shown before stays, with its textures, until the current layer has been drawn
+  if((currentLayer >= layers.size()) || layers.at(currentLayer).isNull())
+    return(node);
+
+  if(node == NULL)
+    node = new TVKQuickNode(window());
+
+  node->upload(layers);
+
+  // Keys must match what is shown, so a stretched keyboard has no highlights
+  const TVKLayerSpec &spec = layers.at(currentLayer)->spec;
+  bool stretched = resizing || (spec.size != QSize((int)width(), (int)height()));
+
+  node->showKeyboard(currentLayer, boundingRect(), stretched);
+
+  QList<QRect> rects;
+  if(!stretched)
+  {
+    for(int p = 0; p < presses.size(); p++)
+    {
+      int k = keyGeometry.find(presses.at(p).row, presses.at(p).column);
+      if(k == -1)
+        continue;
+
+      const TVKKey &key = keyGeometry.key(k);
+      rects.append(key.area);
+
+      // Enter is two rows high, add the lower part
+      if(!key.lower.isEmpty())
+        rects.append(key.lower);
+    }
+  }
+
+  node->showPressed(currentLayer, rects, spec.ratio);
+  node->freeRetired();
+
+  return(node);
+}
+
+// Where the key was pressed
+void TVKQuickKeyboard::mousePressEvent(QMouseEvent *e)
+{
+  pressAt(mousePress, e->position());
+}
+
+// Where the key was released
+void TVKQuickKeyboard::mouseReleaseEvent(QMouseEvent *)
+{
+  releasePress(mousePress);
+}
+
+// Another item took the mouse, the key is let go without changing layer
+void TVKQuickKeyboard::mouseUngrabEvent()
+{
+  int p = findPress(mousePress);
+  if(p == -1)
+    return;
+
+  presses.removeAt(p);
+  update();
+}
+
+// Press and release keys for every touch point that changed
+void TVKQuickKeyboard::touchEvent(QTouchEvent *e)
+{
+  if(e->type() == QEvent::TouchCancel)
+  {
+    touchUngrabEvent();
+    return;
+  }
+
+  const QList<QEventPoint> &points = e->points();
+
+  for(int a = 0; a < points.size(); a++)
+  {
+    const QEventPoint &point = points.at(a);
+
+    if(point.state() == QEventPoint::Pressed)
+      pressAt(point.id(), point.position());
+    else if(point.state() == QEventPoint::Released)
+      releasePress(point.id());
+  }
+}
+
+// Another item took the touch points, nothing more is sent for keys they hold
+void TVKQuickKeyboard::touchUngrabEvent()
+{
+  for(int p = presses.size()-1; p >= 0; p--)
+  {
+    if(presses.at(p).id != mousePress)
+      presses.removeAt(p);
+  }
+
+  update();
+}
+
+// Press the key at a position, every press keeps its own highlight
+void TVKQuickKeyboard::pressAt(int id, const QPointF &position)
+{
+  // Keys must match what is shown
+  if(resizing == true)
+    finishResize();
+
+  // A press without a release
+  int p = findPress(id);
+  if(p != -1)
+    presses.removeAt(p);
+
+  int k = keyGeometry.keyAt(QPoint((int)floor(position.x()), (int)floor(position.y())));
+
+  if(k != -1)
+  {
+    const TVKKey &key = keyGeometry.key(k);
+
+    TVKPress press;
+    press.id     = id;
+    press.row    = key.row;
+    press.column = key.column;
+    press.layer  = currentLayer;
+
+    presses.append(press);
+
+    const TVKKeyDescriptor &d = currentLayout->layers.at(currentLayer).key(key.row, key.column);
+
+    if(d.sendsKey())
+      pressKey(d);
+  }
+
+  // Only the pressed key nodes change
+  update();
+}
+
+// Release the key held by the mouse or a touch point. Shift steps through the layers of the
+// layout when it is released. The font key does nothing here, QML sets the font instead
+void TVKQuickKeyboard::releasePress(int id)
+{
+  int originallayer = currentLayer;
+
+  // Nothing was pressed, e.g. between keys or the press was taken by another item, so the layer stays
+  int p = findPress(id);
+  if(p == -1)
+    return;
+
+  // The key is the one on the layer shown when it was pressed
+  TVKPress press = presses.takeAt(p);
+  TVKKeyDescriptor::Kind kind = currentLayout->layers.at(press.layer).key(press.row, press.column).kind;
+
+  if(kind == TVKKeyDescriptor::Shift)
+    currentLayer = (currentLayer + 1) % currentLayout->layers.size();
+  else if((kind != TVKKeyDescriptor::Font) && (currentLayout->layers.at(currentLayer).latched == false))
+    currentLayer = 0;
+
+  // Changing layer swaps the texture, it was uploaded when it was drawn. If it has not been
+  // drawn yet, the polish draws it before the frame
+  if(originallayer != currentLayer)
+  {
+    polish();
+    emit layerChanged();
+  }
+
+  update();
+}
+
+// Position of the mouse or a touch point in presses
+int TVKQuickKeyboard::findPress(int id) const
+{
+  for(int p = 0; p < presses.size(); p++)
+  {
+    if(presses.at(p).id == id)
+      return(p);
+  }
+
+  return(-1);
+}
+
+// Send a key pressed on the keyboard, with the corrections of the sequence check
+void TVKQuickKeyboard::pressKey(const TVKKeyDescriptor &key)
+{
+  int send[3];
+  int n = sequenceCheck.keysToSend(key.tis620, key.kind == TVKKeyDescriptor::Character, send);
+
+  for(int a = 0; a < n; a++)
+    sendKey(tvkDescribe(send[a]));
+}
+
+// Send a key press by KeyPressed, UnicodeKeyPressed and textPressed
+void TVKQuickKeyboard::sendKey(const TVKKeyDescriptor &key)
+{
+  QStringView text = tvkUnicodeView(key.tis620);
+
+  emit KeyPressed(key.tis620);
+  emit UnicodeKeyPressed(text);
+  emit textPressed(QString::fromRawData(text.data(), text.size()));
+
+  sequenceCheck.sent(key.tis620);
+}
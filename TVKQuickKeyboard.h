@@ -0,0 +1,213 @@
+/**
+ * @file   TVKQuickKeyboard.h
+ * @brief  Thai Virtual Keyboard as a Qt Quick item, drawn from scene graph textures
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKQuickKeyboard_h
+#define TVKQuickKeyboard_h
+
+#include <QQuickItem>
+#include <QSharedPointer>
+#include <QStringView>
+#include <QString>
+#include <QList>
+
+#include "TVKKeyGeometry.h"
+#include "TVKLayerRenderer.h"
+#include "TVKLayerCache.h"
+#include "TVKLayout.h"
+#include "TVKSequenceCheck.h"
+
+class QThread;
+class QTimer;
+class TVKGlyphAtlas;
+
+/// @class Thai Virtual Keyboard for QML. Each layer is uploaded once as a texture and
+/// pressed keys are nodes showing part of the pressed texture, so a press repaints nothing.
+/// Works with every scene graph backend, including software
+class TVKQuickKeyboard : public QQuickItem
+{
+  Q_OBJECT
+  Q_PROPERTY(QString layout READ layoutName WRITE setLayout NOTIFY layoutChanged)
+  Q_PROPERTY(QString fontName READ fontName WRITE setFontName NOTIFY fontChanged)
+  Q_PROPERTY(int fontSize READ fontSize WRITE setFontSize NOTIFY fontChanged)
+  Q_PROPERTY(int keyLayer READ keyLayer NOTIFY layerChanged)
+
+public:
+  /// Constructor
+  TVKQuickKeyboard(QQuickItem *parent = NULL);
+
+  /// Destructor
+  ~TVKQuickKeyboard();
+
+  /// Show a layout from TVKLayouts, false if there is no layout with that name
+  bool setLayout(const QString &name);
+
+  /// Name of the layout shown
+  QString layoutName() const { return(currentLayout->name); }
+
+  /// Set the font of the keycaps
+  void setFontName(const QString &name);
+
+  /// Name of font
+  QString fontName() const { return(tvkFontName); }
+
+  /// Set the size of the keycaps, the implicit size follows
+  void setFontSize(int size);
+
+  /// Size of font
+  int fontSize() const { return(tvkFontSize); }
+
+  /// Layer of the layout shown, QQuickItem has a layer property already
+  int keyLayer() const { return(currentLayer); }
+
+  /// Check the order of Thai characters before sending them
+  void setSequenceCheck(TVKSequenceCheck::Mode mode, bool correct = true);
+
+signals:
+  /// Key press
+  void KeyPressed(int tis620val);
+
+  /// Key press as Unicode, the view is of static storage
+  void UnicodeKeyPressed(QStringView text);
+
+  /// Key press as Unicode for QML, which cannot take a view. The string is of the same static
+  /// storage, so nothing is allocated for it
+  void textPressed(const QString &text);
+
+  /// Layout changed
+  void layoutChanged();
+
+  /// Font or font size changed
+  void fontChanged();
+
+  /// Shift changed the layer shown
+  void layerChanged();
+
+protected:
+  /// Where the key was pressed
+  void mousePressEvent(QMouseEvent *e);
+
+  /// Where the key was released
+  void mouseReleaseEvent(QMouseEvent *e);
+
+  /// Another item took the mouse
+  void mouseUngrabEvent();
+
+  /// Press and release keys for every touch point
+  void touchEvent(QTouchEvent *e);
+
+  /// Another item took the touch points
+  void touchUngrabEvent();
+
+  /// Stretch the keyboard until the size settles
+  void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry);
+
+  /// Draw again for a new window or device pixel ratio
+  void itemChange(ItemChange change, const ItemChangeData &value);
+
+  /// Draw the current layer before the frame is synchronised
+  void updatePolish();
+
+  /// Upload new layers and move the pressed key nodes, on the render thread
+  QSGNode *updatePaintNode(QSGNode *old, UpdatePaintNodeData *data);
+
+private slots:
+  /// A layer was drawn on the worker thread
+  void keyboardRendered(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed);
+
+  /// Draw the keyboard at its final size
+  void finishResize();
+
+private:
+  /// Everything needed to draw a layer at the current size and font
+  TVKLayerSpec layerSpec(int layer) const;
+
+  /// Draw the current layer now unless it is up to date, the other layers in the background
+  void drawKeyboard();
+
+  /// Font and size changed, measure the keyboard again
+  void refreshFont();
+
+  /// Press the key at a position
+  void pressAt(int id, const QPointF &position);
+
+  /// Release the key held by the mouse or a touch point
+  void releasePress(int id);
+
+  /// Position of the mouse or a touch point in presses, -1 if it is not pressing a key
+  int findPress(int id) const;
+
+  /// Send a key pressed on the keyboard, after the sequence check
+  void pressKey(const TVKKeyDescriptor &key);
+
+  /// Send a key press by the signals
+  void sendKey(const TVKKeyDescriptor &key);
+
+  /// Layout shown
+  QSharedPointer<const TVKLayout> currentLayout;
+
+  /// Layer of the layout shown
+  int currentLayer;
+
+  /// Drawn layers by layer of the layout, null until drawn. They may be for an old size
+  QList<QSharedPointer<const TVKLayer> > layers;
+
+  /// Key rectangles for the size of the item
+  TVKKeyGeometry keyGeometry;
+
+  /// Keys held down, one for the mouse and each touch point
+  QList<TVKPress> presses;
+
+  /// Name of font
+  QString tvkFontName;
+
+  /// Size of font
+  int tvkFontSize;
+
+  /// Add a spacing character for NSM
+  bool addSpaceNSM;
+
+  /// Size of action keys: 0 = small, 1 = medium, 2 = large
+  int actionKeySize;
+
+  /// Checks the order of Thai characters sent
+  TVKSequenceCheck sequenceCheck;
+
+  /// The item is being resized and shows a stretched texture
+  bool resizing;
+
+  /// Delays drawing until resizing stops
+  QTimer *resizeTimer;
+
+  /// Thread drawing the layers not shown
+  QThread *renderThread;
+
+  /// Draws layers on renderThread
+  TVKLayerRenderer *renderer;
+
+  /// Layers asked of the worker thread and not drawn yet
+  QList<TVKLayerSpec> renderQueue;
+
+  /// Rasterised keycaps for the current font, kept for the worker thread
+  QSharedPointer<TVKGlyphAtlas> glyphs;
+};
+
+#endif  // TVKQuickKeyboard_h
@@ -0,0 +1,113 @@
+/**
+ * @file   TVKScanCodes.h
+ * @brief  Positions of the keys of a physical keyboard on the virtual keyboard
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKScanCodes_h
+#define TVKScanCodes_h
+
+#include <QtGlobal>
+
+#include <array>
+#include <utility>
+
+#include "TVKKeyTable.h"
+
+/// @struct A physical key and the key at the same place on the virtual keyboard.
+///
+/// Scan codes name the position of a key, not what is printed on it, so a Latin keyboard of any
+/// layout types Kedmanee. The keymap puts the caps lock position at row 2 column 1 with no
+/// physical key, and the backslash key, which is next to left shift on ISO keyboards, at row 3
+/// column 1
+struct TVKScanCode
+{
+  /// Scan code set 1, as Windows gives it. Linux evdev codes are the same for these keys
+  quint8 setOne;
+
+  /// macOS virtual key code
+  quint8 mac;
+
+  /// Row of the keymap
+  quint8 row;
+
+  /// Column of the keymap
+  quint8 column;
+};
+
+constexpr TVKScanCode tvkScanCodes[] = {
+  // Number row
+  { 41, 0x32, 0,  0 }, {  2, 0x12, 0,  1 }, {  3, 0x13, 0,  2 }, {  4, 0x14, 0,  3 }, {  5, 0x15, 0,  4 },
+  {  6, 0x17, 0,  5 }, {  7, 0x16, 0,  6 }, {  8, 0x1a, 0,  7 }, {  9, 0x1c, 0,  8 }, { 10, 0x19, 0,  9 },
+  { 11, 0x1d, 0, 10 }, { 12, 0x1b, 0, 11 }, { 13, 0x18, 0, 12 }, { 14, 0x33, 0, 13 },
+
+  // Q row
+  { 15, 0x30, 1,  0 }, { 16, 0x0c, 1,  1 }, { 17, 0x0d, 1,  2 }, { 18, 0x0e, 1,  3 }, { 19, 0x0f, 1,  4 },
+  { 20, 0x11, 1,  5 }, { 21, 0x10, 1,  6 }, { 22, 0x20, 1,  7 }, { 23, 0x22, 1,  8 }, { 24, 0x1f, 1,  9 },
+  { 25, 0x23, 1, 10 }, { 26, 0x21, 1, 11 }, { 27, 0x1e, 1, 12 }, { 28, 0x24, 1, 13 },
+
+  // A row
+  { 30, 0x00, 2,  2 }, { 31, 0x01, 2,  3 }, { 32, 0x02, 2,  4 }, { 33, 0x03, 2,  5 }, { 34, 0x05, 2,  6 },
+  { 35, 0x04, 2,  7 }, { 36, 0x26, 2,  8 }, { 37, 0x28, 2,  9 }, { 38, 0x25, 2, 10 }, { 39, 0x29, 2, 11 },
+  { 40, 0x27, 2, 12 },
+
+  // Z row, with backslash and the ISO key left of Z both at column 1
+  { 43, 0x2a, 3,  1 }, { 86, 0x0a, 3,  1 }, { 44, 0x06, 3,  2 }, { 45, 0x07, 3,  3 }, { 46, 0x08, 3,  4 },
+  { 47, 0x09, 3,  5 }, { 48, 0x0b, 3,  6 }, { 49, 0x2d, 3,  7 }, { 50, 0x2e, 3,  8 }, { 51, 0x2b, 3,  9 },
+  { 52, 0x2f, 3, 10 }, { 53, 0x2c, 3, 11 },
+
+  // Space bar
+  { 57, 0x31, 4,  0 }
+};
+
+// Keymap index of the physical key with a code, -1 if there is none
+constexpr int tvkScanKey(int code, bool mac)
+{
+  for(const TVKScanCode &s : tvkScanCodes)
+  {
+    if((mac ? s.mac : s.setOne) == code)
+      return(s.row*15 + s.column);
+  }
+
+  return(-1);
+}
+
+// Keymap index for every code below 128
+template<std::size_t... c>
+constexpr std::array<qint8, 128> tvkScanKeys(bool mac, std::index_sequence<c...>)
+{
+  return(std::array<qint8, 128>{{ (qint8)tvkScanKey(c, mac)... }});
+}
+
+/// Keymap index by scan code set 1 or evdev code, -1 if no key has the code
+constexpr std::array<qint8, 128> tvkSetOneKeys = tvkScanKeys(false, std::make_index_sequence<128>());
+
+/// Keymap index by macOS virtual key code, -1 if no key has the code
+constexpr std::array<qint8, 128> tvkMacKeys = tvkScanKeys(true, std::make_index_sequence<128>());
+
+// Q, A, Z and the number row type Kedmanee on both tables, and the action keys are where they are drawn
+static_assert((tvk_keymap[tvkSetOneKeys[16]] == 230) && (tvk_keymap[tvkMacKeys[0x0c]] == 230) &&
+              (tvk_keymap[tvkSetOneKeys[30]] == 191) && (tvk_keymap[tvkMacKeys[0x00]] == 191) &&
+              (tvk_keymap[tvkSetOneKeys[44]] == 188) && (tvk_keymap[tvkMacKeys[0x06]] == 188) &&
+              (tvk_keymap[tvkSetOneKeys[2]] == 229) && (tvk_keymap[tvkMacKeys[0x12]] == 229) &&
+              (tvk_keymap[tvkSetOneKeys[43]] == 163) && (tvk_keymap[tvkSetOneKeys[14]] == 8) &&
+              (tvk_keymap[tvkSetOneKeys[15]] == 9) && (tvk_keymap[tvkSetOneKeys[28]] == 10) &&
+              (tvk_keymap[tvkSetOneKeys[57]] == 32) && (tvkSetOneKeys[0] == -1), "scan codes");
+
+#endif  // TVKScanCodes_h
@@ -0,0 +1,212 @@
+/**
+ * @file   TVKSequenceCheck.cc
+ * @brief  Thai input sequence checking, as in WTT 2.0
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKSequenceCheck.h"
+
+#include <array>
+#include <utility>
+
+typedef TVKSequenceCheck S;
+
+// Class of a TIS-620 value. 0xdb to 0xde and 0xfc up are not assigned
+constexpr S::Class tvkClassify(int c)
+{
+  return(((c < 32) || (c == 127) || ((c >= 128) && (c < 160))) ? S::Ctrl :
+         (c < 161)  ? S::Non :
+         ((c == 0xc4) || (c == 0xc6)) ? S::FV3 :
+         (c <= 0xce) ? S::Cons :
+         (c == 0xcf) ? S::Non :
+         ((c == 0xd0) || (c == 0xd2) || (c == 0xd3)) ? S::FV1 :
+         ((c == 0xd1) || (c == 0xd6)) ? S::AV2 :
+         (c == 0xd4) ? S::AV1 :
+         ((c == 0xd5) || (c == 0xd7)) ? S::AV3 :
+         (c == 0xd8) ? S::BV1 :
+         (c == 0xd9) ? S::BV2 :
+         (c == 0xda) ? S::BD :
+         (c < 0xdf)  ? S::Ctrl :
+         (c == 0xdf) ? S::Non :
+         (c <= 0xe4) ? S::LV :
+         (c == 0xe5) ? S::FV2 :
+         (c == 0xe6) ? S::Non :
+         (c == 0xe7) ? S::AD2 :
+         (c <= 0xeb) ? S::Tone :
+         (c <= 0xed) ? S::AD1 :
+         (c == 0xee) ? S::AD3 :
+         (c <= 0xfb) ? S::Non : S::Ctrl);
+}
+
+// Class of every TIS-620 value
+template<std::size_t... c>
+constexpr std::array<S::Class, 256> tvkClassifyAll(std::index_sequence<c...>)
+{
+  return(std::array<S::Class, 256>{{ tvkClassify(c)... }});
+}
+
+static constexpr std::array<S::Class, 256> classes = tvkClassifyAll(std::make_index_sequence<256>());
+
+static_assert((classes[0xa1] == S::Cons) && (classes[0xc4] == S::FV3) && (classes[0xd3] == S::FV1) &&
+              (classes[0xe0] == S::LV) && (classes[0xe8] == S::Tone) && (classes[0xee] == S::AD3) &&
+              (classes['a'] == S::Non) && (classes[10] == S::Ctrl), "character classes");
+
+// WTT 2.0 sequence table, previous character class by row and next by column.
+// A = accept, C = compose on the previous character, S = rejected by strict mode, R = reject,
+// X = control characters are always accepted. Columns are in the order of the rows
+static constexpr char sequence[S::Classes][S::Classes+1] = {
+  "XAAARRARRRRRRRRRR",  // Ctrl
+  "XAAASSARRRRRRRRRR",  // Non
+  "XAAAASACCCCCCCCCC",  // Cons
+  "XSASSSSRRRRRRRRRR",  // LV
+  "XSASASARRRRRRRRRR",  // FV1
+  "XAAAASARRRRRRRRRR",  // FV2
+  "XAAASASRRRRRRRRRR",  // FV3
+  "XAAASSARRRCCRRRRR",  // BV1
+  "XAAASSARRRCRRRRRR",  // BV2
+  "XAAASSARRRRRRRRRR",  // BD
+  "XAAAAAARRRRRRRRRR",  // Tone
+  "XAAASSARRRRRRRRRR",  // AD1
+  "XAAASSARRRRRRRRRR",  // AD2
+  "XAAASSARRRRRRRRRR",  // AD3
+  "XAAASSARRRCCRRRRR",  // AV1
+  "XAAASSARRRCRRRRRR",  // AV2
+  "XAAASSARRRCRCRRRR"   // AV3
+};
+
+// Every character of a word may follow the one before it in strict mode
+template<std::size_t n>
+constexpr bool tvkStrictAccepts(const int (&word)[n])
+{
+  for(std::size_t a = 1; a < n; a++)
+  {
+    char op = sequence[classes[word[a-1]]][classes[word[a]]];
+    if((op == 'R') || (op == 'S'))
+      return(false);
+  }
+
+  return(true);
+}
+
+// Strict mode accepts SARA A after SARA AA, as in common words, and rejects SARA AA after SARA U
+constexpr int koh[]    = { 0xe0, 0xa1, 0xd2, 0xd0 };        // เกาะ
+constexpr int phroh[]  = { 0xe0, 0xbe, 0xc3, 0xd2, 0xd0 };  // เพราะ
+constexpr int khun[]   = { 0xa4, 0xd8, 0xb3 };              // คุณ
+constexpr int khuaa[]  = { 0xa4, 0xd8, 0xd2 };              // คุา
+
+static_assert(tvkStrictAccepts(koh) && tvkStrictAccepts(phroh) && tvkStrictAccepts(khun) &&
+              !tvkStrictAccepts(khuaa), "WTT 2.0 strict sequences");
+
+// Constructor
+TVKSequenceCheck::TVKSequenceCheck() : head(0), count(0), checkMode(Off), correction(true)
+{
+}
+
+// Set how strict the check is
+void TVKSequenceCheck::setMode(Mode mode, bool correct)
+{
+  checkMode  = mode;
+  correction = correct;
+}
+
+// Class of a TIS-620 value
+TVKSequenceCheck::Class TVKSequenceCheck::classOf(int tis620)
+{
+  return(classes[tis620 & 0xff]);
+}
+
+// A character of class after may follow one of class before
+bool TVKSequenceCheck::allowed(Class before, Class after) const
+{
+  char op = sequence[before][after];
+
+  return((op != 'R') && ((op != 'S') || (checkMode != Strict)));
+}
+
+// Keys to send for a key pressed. A correction erases the last character with backspace, then
+// sends the key and, if reordering, the erased character after it
+int TVKSequenceCheck::keysToSend(int tis620, bool character, int keys[3]) const
+{
+  Action action = character ? check(tis620) : Accept;
+
+  if(action == Reject)
+    return(0);
+
+  int n = 0;
+
+  if(action != Accept)
+    keys[n++] = 8;
+
+  keys[n++] = tis620;
+
+  if(action == Reorder)
+    keys[n++] = last();
+
+  return(n);
+}
+
+// Character sent n before the last
+int TVKSequenceCheck::previous(int n) const
+{
+  if(n >= count)
+    return(0);
+
+  return(history[(head - n + historySize) % historySize]);
+}
+
+// What pressing a key would do. Only marks that sit on the same consonant are corrected: a mark
+// typed after one it should come before is reordered, and a second mark replaces the first
+TVKSequenceCheck::Action TVKSequenceCheck::check(int tis620) const
+{
+  if(checkMode == Off)
+    return(Accept);
+
+  Class next  = classOf(tis620);
+  Class last  = classOf(previous(0));
+  Class base  = classOf(previous(1));
+
+  if(allowed(last, next))
+    return(Accept);
+
+  if((correction == false) || (count == 0) || (sequence[base][next] != 'C') || (sequence[base][last] != 'C'))
+    return(Reject);
+
+  return((sequence[next][last] == 'C') ? Reorder : Replace);
+}
+
+// Follow a character that has been sent
+void TVKSequenceCheck::sent(int tis620)
+{
+  if(tis620 == 8)
+  {
+    // Backspace
+    if(count > 0)
+    {
+      head = (head - 1 + historySize) % historySize;
+      count--;
+    }
+    return;
+  }
+
+  head = (head + 1) % historySize;
+  history[head] = tis620;
+
+  if(count < historySize)
+    count++;
+}
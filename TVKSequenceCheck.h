@@ -0,0 +1,133 @@
+/**
+ * @file   TVKSequenceCheck.h
+ * @brief  Thai input sequence checking, as in WTT 2.0
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKSequenceCheck_h
+#define TVKSequenceCheck_h
+
+#include <QtGlobal>
+
+/// @class Decides whether a character may follow the characters sent before it.
+///
+/// Every TIS-620 value has one of the 17 WTT 2.0 classes, and a table of class pairs says
+/// whether the second may follow the first. Checking a key is two table lookups
+class TVKSequenceCheck
+{
+public:
+  /// How strict the check is
+  enum Mode
+  {
+    Off,     ///< Every character is sent
+    Basic,   ///< Sequences that cannot be displayed are rejected
+    Strict   ///< Sequences that are not Thai spelling are rejected too
+  };
+
+  /// Character classes, with their WTT 2.0 names
+  enum Class : quint8
+  {
+    Ctrl,  ///< Control characters
+    Non,   ///< Characters that are not Thai, Thai digits and symbols
+    Cons,  ///< Consonants
+    LV,    ///< Leading vowels
+    FV1,   ///< Following vowels SARA A, SARA AA and SARA AM
+    FV2,   ///< LAKKHANGYAO
+    FV3,   ///< RU and LU
+    BV1,   ///< SARA U
+    BV2,   ///< SARA UU
+    BD,    ///< PHINTHU
+    Tone,  ///< Tone marks
+    AD1,   ///< THANTHAKHAT and NIKHAHIT
+    AD2,   ///< MAITAIKHU
+    AD3,   ///< YAMAKKAN
+    AV1,   ///< SARA I
+    AV2,   ///< MAI HAN-AKAT and SARA UE
+    AV3,   ///< SARA II and SARA UEE
+    Classes
+  };
+
+  /// What pressing a key does
+  enum Action
+  {
+    Accept,   ///< Send the character
+    Reorder,  ///< Send it before the last character, which is erased and sent again
+    Replace,  ///< Send it in place of the last character
+    Reject    ///< Send nothing
+  };
+
+  /// Constructor
+  TVKSequenceCheck();
+
+  /// Set how strict the check is, and whether marks typed in the wrong order are corrected
+  void setMode(Mode mode, bool correct = true);
+
+  /// How strict the check is
+  Mode mode() const { return(checkMode); }
+
+  /// Marks typed in the wrong order are corrected
+  bool corrects() const { return(correction); }
+
+  /// What pressing a key with a TIS-620 value would do, nothing is changed
+  Action check(int tis620) const;
+
+  /// TIS-620 values to send for a key, with a backspace before it and the erased character after
+  /// it for a correction. Keys that are not characters are not checked. Returns how many, 0 if the
+  /// key is rejected
+  int keysToSend(int tis620, bool character, int keys[3]) const;
+
+  /// Follow a character that has been sent, backspace takes back the last one
+  void sent(int tis620);
+
+  /// The last character sent, 0 if nothing is known
+  int last() const { return(previous(0)); }
+
+  /// Forget what was sent
+  void reset() { count = 0; }
+
+  /// Class of a TIS-620 value
+  static Class classOf(int tis620);
+
+private:
+  /// A character of class after may follow one of class before
+  bool allowed(Class before, Class after) const;
+
+  /// Character sent n before the last, 0 if it is not known
+  int previous(int n) const;
+
+  /// Characters remembered, enough to take back several with backspace
+  static const int historySize = 16;
+
+  /// Last characters sent, in a ring
+  quint16 history[historySize];
+
+  /// Position of the last character in history
+  int head;
+
+  /// Number of characters remembered
+  int count;
+
+  /// How strict the check is
+  Mode checkMode;
+
+  /// Marks typed in the wrong order are corrected
+  bool correction;
+};
+
+#endif  // TVKSequenceCheck_h
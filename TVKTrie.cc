@@ -0,0 +1,228 @@
+/**
+ * @file   TVKTrie.cc
+ * @brief  Frequency ranked word list, memory-mapped from a file
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TVKTrie.h"
+
+#include <QtEndian>
+
+#include <queue>
+#include <string.h>
+
+// File layout, all values little-endian:
+//
+//   header  "TVKTRIE1", root offset (4 bytes), number of words (4 bytes)
+//   node    frequency of the word ending here or 0, highest frequency below, number of children
+//           (4 bytes each), then for each child its label (2 bytes), 2 bytes unused and offset (4 bytes)
+//
+// Nodes start on 4 byte boundaries and children are sorted by label
+static const char magic[8] = { 'T', 'V', 'K', 'T', 'R', 'I', 'E', '1' };
+static const int headerSize = 16;
+static const int nodeSize   = 12;
+static const int childSize  = 8;
+
+// Nodes looked at for one completion, a damaged file cannot make a lookup run for ever
+static const int visitLimit = 4096;
+
+// Read a value from the file
+static inline quint32 read32(const uchar *p)
+{
+  return(qFromLittleEndian<quint32>(p));
+}
+
+// Constructor
+TVKTrie::TVKTrie() : data(NULL), size(0), root(0), wordCount(0)
+{
+}
+
+// Destructor
+TVKTrie::~TVKTrie()
+{
+  close();
+}
+
+// Map a dictionary file, only the header is read
+bool TVKTrie::open(const QString &filename)
+{
+  close();
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    return(false);
+
+  size = file.size();
+  const uchar *mapped = (size >= headerSize) ? file.map(0, size) : NULL;
+
+  if((mapped == NULL) || (memcmp(mapped, magic, sizeof(magic)) != 0))
+  {
+    file.close();
+    size = 0;
+    return(false);
+  }
+
+  data      = mapped;
+  root      = read32(data+8);
+  wordCount = read32(data+12);
+
+  if(node(root) == NULL)
+  {
+    close();
+    return(false);
+  }
+
+  return(true);
+}
+
+// Unmap the dictionary
+void TVKTrie::close()
+{
+  if(data != NULL)
+    file.unmap((uchar *)data);
+
+  file.close();
+
+  data      = NULL;
+  size      = 0;
+  root      = 0;
+  wordCount = 0;
+}
+
+// Node at an offset, NULL if it or its children are outside the file
+const uchar *TVKTrie::node(quint32 offset) const
+{
+  if((offset < headerSize) || (offset % 4 != 0) || ((qint64)offset + nodeSize > size))
+    return(NULL);
+
+  const uchar *n = data + offset;
+
+  if((qint64)offset + nodeSize + (qint64)read32(n+8)*childSize > size)
+    return(NULL);
+
+  return(n);
+}
+
+// Child of a node with a label, found by binary search
+quint32 TVKTrie::child(const uchar *n, char16_t label) const
+{
+  if(n == NULL)
+    return(0);
+
+  const uchar *children = n + nodeSize;
+  int low = 0, high = (int)read32(n+8) - 1;
+
+  while(low <= high)
+  {
+    int middle = (low + high)/2;
+    char16_t found = qFromLittleEndian<quint16>(children + middle*childSize);
+
+    if(found == label)
+      return(read32(children + middle*childSize + 4));
+
+    if(found < label)
+      low = middle + 1;
+    else
+      high = middle - 1;
+  }
+
+  return(0);
+}
+
+// A word or a subtree waiting to be looked at, by frequency
+struct TVKCandidate
+{
+  /// Frequency of the word, or the highest frequency in the subtree
+  quint32 frequency;
+
+  /// Offset of the subtree, 0 for a word
+  quint32 offset;
+
+  /// The word, or the prefix of the subtree
+  QString word;
+
+  /// Lower frequencies come out of the queue last, words before subtrees of the same frequency
+  bool operator<(const TVKCandidate &c) const
+  {
+    if(frequency != c.frequency)
+      return(frequency < c.frequency);
+
+    return((offset != 0) && (c.offset == 0));
+  }
+};
+
+// The most frequent words starting with prefix. A subtree is only opened when its best word could be
+// next, so the work depends on count and not on the size of the dictionary
+QStringList TVKTrie::complete(QStringView prefix, int count) const
+{
+  QStringList found;
+
+  if(!isOpen() || (count < 1))
+    return(found);
+
+  quint32 offset = root;
+  for(int a = 0; (a < prefix.size()) && (offset != 0); a++)
+    offset = child(node(offset), prefix.at(a).unicode());
+
+  const uchar *start = node(offset);
+  if(start == NULL)
+    return(found);
+
+  std::priority_queue<TVKCandidate> queue;
+  queue.push(TVKCandidate{ read32(start+4), offset, prefix.toString() });
+
+  int visited = 0;
+
+  while(!queue.empty() && (found.size() < count) && (visited < visitLimit))
+  {
+    TVKCandidate c = queue.top();
+    queue.pop();
+
+    if(c.offset == 0)
+    {
+      found.append(c.word);
+      continue;
+    }
+
+    const uchar *n = node(c.offset);
+    if(n == NULL)
+      continue;
+
+    visited++;
+
+    if(read32(n) > 0)
+      queue.push(TVKCandidate{ read32(n), 0, c.word });
+
+    const uchar *children = n + nodeSize;
+    int number = (int)read32(n+8);
+
+    for(int a = 0; a < number; a++)
+    {
+      quint32 childoffset = read32(children + a*childSize + 4);
+      const uchar *childnode = node(childoffset);
+      if(childnode == NULL)
+        continue;
+
+      QChar label(qFromLittleEndian<quint16>(children + a*childSize));
+      queue.push(TVKCandidate{ read32(childnode+4), childoffset, c.word + label });
+    }
+  }
+
+  return(found);
+}
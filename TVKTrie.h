@@ -0,0 +1,87 @@
+/**
+ * @file   TVKTrie.h
+ * @brief  Frequency ranked word list, memory-mapped from a file
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TVKTrie_h
+#define TVKTrie_h
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+/// @class Frequency ranked word list, made by Dictionary/maketrie.py.
+///
+/// The file is mapped, not read, so opening takes the same time for any size of dictionary.
+/// Each node holds the frequency of the word ending there, the highest frequency below it and
+/// its children sorted by UTF-16 code unit, so the most frequent completions are found without
+/// visiting the rest of the subtree.
+class TVKTrie
+{
+public:
+  /// Constructor
+  TVKTrie();
+
+  /// Destructor
+  ~TVKTrie();
+
+  /// Map a dictionary file, false if it cannot be opened or is not a dictionary
+  bool open(const QString &filename);
+
+  /// Unmap the dictionary
+  void close();
+
+  /// A dictionary is open
+  bool isOpen() const { return(data != NULL); }
+
+  /// File the dictionary was opened from
+  QString fileName() const { return(file.fileName()); }
+
+  /// Number of words in the dictionary
+  quint32 words() const { return(wordCount); }
+
+  /// The most frequent words starting with prefix, most frequent first
+  QStringList complete(QStringView prefix, int count) const;
+
+private:
+  /// Node at an offset, NULL if it is outside the file
+  const uchar *node(quint32 offset) const;
+
+  /// Child of a node with a label, 0 if there is none
+  quint32 child(const uchar *n, char16_t label) const;
+
+  /// The mapped file
+  QFile file;
+
+  /// Start of the mapping, NULL if nothing is open
+  const uchar *data;
+
+  /// Size of the mapping
+  qint64 size;
+
+  /// Offset of the root node
+  quint32 root;
+
+  /// Number of words
+  quint32 wordCount;
+};
+
+#endif  // TVKTrie_h
@@ -21,51 +21,62 @@
  */ 
  
 #include "ThaiVirtualKeyboard.h" 
+#include "TVKGlyphAtlas.h"
+#include "TVKLayerRenderer.h"
+#include "TVKLayerCache.h"
+#include "TVKFontIndex.h"
+#include "TVKFontChooser.h"
+#include "TVKKeyQueue.h"
+#include "TVKInstrumentation.h"
+#include "TVKKeyTable.h"
+#include "TVKLayout.h"
+#include "TVKTrie.h"
+#include "TVKPredictionBar.h"
+#include "TVKScanCodes.h"
 
 #include <QPainter>
-#include <QPixmap>
 #include <QImage>
 #include <QMouseEvent>
-#include <QFontDialog>
+#include <QTouchEvent>
 #include <QSettings>
 #include <QApplication>
 #include <QScreen>
 #include <QFontDatabase>
 #include <QFont>
 #include <QList>
+#include <QTimer>
+#include <QThread>
 
 #include <math.h>
+#include <string.h>
+
+// Press made by the mouse rather than a touch point
+static const int mousePress = -1;
+
+// Press made by a physical key, the keymap index is subtracted so each key has its own
+static const int physicalPress = -2;
+
+// Time without a resize before the keyboard is drawn at the new size, ms
+static const int resizeQuietPeriod = 100;
+
+// Number of drawn keyboards kept for each layer of the layout and device pixel ratio, enough for
+// three zoom levels and one more
+static const int preparedPerLayer = 4;
+
+// Report timings when the application exits, to a file as well if TVK_PERF_FILE is set. The
+// histograms are of every keyboard in the process, so they are reported once
+static void reportTimings()
+{
+  if(!TVKInstrumentation::isEnabled())
+    return;
+
+  TVKInstrumentation::dump();
+
+  QString filename = qEnvironmentVariable("TVK_PERF_FILE");
+  if(!filename.isEmpty())
+    TVKInstrumentation::dump(filename);
+}
 
-#include "Multisize/enter_large.xpm"
-#include "Multisize/enter_medium.xpm"
-#include "Multisize/enter_small.xpm"
-#include "Multisize/backspace_large.xpm"
-#include "Multisize/backspace_medium.xpm"
-#include "Multisize/backspace_small.xpm"
-#include "Multisize/tab_large.xpm"
-#include "Multisize/tab_medium.xpm"
-#include "Multisize/tab_small.xpm"
-#include "Multisize/shift_large.xpm"
-#include "Multisize/shift_medium.xpm"
-#include "Multisize/shift_small.xpm"
-#include "Multisize/font_large.xpm"
-#include "Multisize/font_medium.xpm"
-#include "Multisize/font_small.xpm"
-
-int tvk_keymap[75] = {
-  239, 229,  47,  45, 192, 182, 216, 214, 164, 181, 168, 162, 170,  8,  0,
-    9, 230, 228, 211, 190, 208, 209, 213, 195, 185, 194, 186, 197, 10, 10,
-    3, 238, 191, 203, 161, 180, 224, 233, 232, 210, 202, 199, 167,  10, 10,
-    1, 163, 188, 187, 225, 205, 212, 215, 183, 193, 227, 189,   2,  2,  0,
-   32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32, 32, 32 };
-
-int tvk_shifted_keymap[75] = {
-  251,  43, 241, 242, 243, 244, 217, 223, 245, 246, 247, 248, 249,  8,  0,
-    9, 240,  34, 174, 177, 184, 237, 234, 179, 207, 173, 176,  44, 10, 10,
-    3, 250, 196, 166, 175, 226, 172, 231, 235, 201, 200, 171,  46,  10, 10, 
-    1, 165,  40,  41, 169, 206, 218, 236,  63, 178, 204, 198,   2,  2,  0,
-   32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32,  32, 32, 32 };
-  
 ThaiVirtualKeyboard::ThaiVirtualKeyboard(QWidget *parent) : QLabel(parent)
 {
   actionKeySize = 0;  // temporary initialisation value
@@ -74,60 +85,96 @@ ThaiVirtualKeyboard::ThaiVirtualKeyboard(QWidget *parent) : QLabel(parent)
   columns = 15;
   rows = 5;
 
-  highDPI = false;
+  // Images are allocated when they are first drawn, at the resolution of the screen
+  thekeyboard     = new QImage;
+  pressedkeyboard = new QImage;
 
-/*
-  // Images for normal and shifted keymaps
-  if(((QGuiApplication*)QCoreApplication::instance())->primaryScreen()->devicePixelRatio() >= 2)
-  {
-    highDPI = true;
+  // Layers that are not shown are drawn on a worker thread
+  qRegisterMetaType<TVKLayerSpec>("TVKLayerSpec");
+  qRegisterMetaType<QList<TVKSizeStep> >("QList<TVKSizeStep>");
 
-    thekeyboard   = new QPixmap(this->width()*2, this->height()*2);
-    shiftkeyboard = new QPixmap(this->width()*2, this->height()*2);
-  }
-  else
-*/
-  {
-    thekeyboard   = new QPixmap(this->width(), this->height());
-    shiftkeyboard = new QPixmap(this->width(), this->height());
-  }
-
-  // Allocate action keys
-  pix_backspace_large  = new QPixmap(backspace_large);
-  pix_backspace_medium = new QPixmap(backspace_medium);
-  pix_backspace_small  = new QPixmap(backspace_small);
-  pix_tab_large        = new QPixmap(tab_large);
-  pix_tab_medium       = new QPixmap(tab_medium);
-  pix_tab_small        = new QPixmap(tab_small);
-  pix_enter_large      = new QPixmap(enter_large);
-  pix_enter_medium     = new QPixmap(enter_medium);
-  pix_enter_small      = new QPixmap(enter_small);
-  pix_shift_large      = new QPixmap(shift_large);
-  pix_shift_medium     = new QPixmap(shift_medium);
-  pix_shift_small      = new QPixmap(shift_small);
-  pix_font_large       = new QPixmap(font_large);
-  pix_font_medium      = new QPixmap(font_medium);
-  pix_font_small       = new QPixmap(font_small);
-
-  shifted = false;
-  keydown = false;
+  renderPending = false;
+  renderThread  = new QThread(this);
+  renderer      = new TVKLayerRenderer;
+  renderer->moveToThread(renderThread);
+
+  connect(renderThread, SIGNAL(finished()), renderer, SLOT(deleteLater()));
+  connect(renderer, SIGNAL(layerRendered(TVKLayerSpec,QImage,QImage)),
+          this, SLOT(keyboardRendered(TVKLayerSpec,QImage,QImage)));
+  connect(renderer, SIGNAL(ladderMeasured(QString,bool,QList<TVKSizeStep>)),
+          this, SLOT(ladderMeasured(QString,bool,QList<TVKSizeStep>)));
+
+  renderThread->start();
+
+  currentLayer = 0;
+  memoryMode   = FullColour;
+  physicalKeys = false;
+
+  // Wait for the size to settle before drawing after a resize
+  resizing = false;
+  resizeTimer = new QTimer(this);
+  resizeTimer->setSingleShot(true);
+  connect(resizeTimer, SIGNAL(timeout()), this, SLOT(finishResize()));
+
+  // TextCommitted is off until a window is set
+  commitWindow = -1;
+  commitTimer = new QTimer(this);
+  commitTimer->setSingleShot(true);
+  connect(commitTimer, SIGNAL(timeout()), this, SLOT(commitText()));
+
+  keyQueue    = NULL;
+  utf8Sink    = NULL;
+  utf8Context = NULL;
+
+  // Words are suggested once a dictionary is set
+  dictionary    = NULL;
+  predictionBar = NULL;
 
   setFocusPolicy(Qt::StrongFocus);
 
-  QSettings settings("lyndonhill.com", "TVK");
+  // Each finger presses keys of its own
+  setAttribute(Qt::WA_AcceptTouchEvents);
+
+  // The first keyboard made has the timings reported when the application exits
+  static bool reportingTimings = false;
+  if(!reportingTimings)
+  {
+    qAddPostRoutine(reportTimings);
+    reportingTimings = true;
+  }
 
-  tvkFontName = settings.value("font/name", "Arial").toString();
-  tvkFontSize = settings.value("font/size", 24).toInt();
+  // Thai fonts are found in the background
+  TVKFontIndex::instance();
+
+  {
+    TVKScopedTimer timing(TVKInstrumentation::Settings);
+    QSettings settings("lyndonhill.com", "TVK");
+
+    tvkFontName = settings.value("font/name", "Arial").toString();
+    tvkFontSize = settings.value("font/size", 24).toInt();
+
+    // Font sizes for Ctrl+8 and Ctrl+9
+    zoomSmallest = settings.value("zoom/smallest", 6).toInt();
+    zoomLargest  = settings.value("zoom/largest", 96).toInt();
+
+    currentLayout = TVKLayouts::find(settings.value("layout/name", "Kedmanee").toString());
+  }
+
+  // The layout may have been loaded from a file that is not loaded now
+  if(currentLayout.isNull())
+    currentLayout = TVKLayouts::standard();
 
   previousFontName = tvkFontName;
   previousFontSize = tvkFontSize;
 
+  ladderNSM = true;
+
   // Add dotted circle for NSM
 #ifdef _WIN32
   addSpaceNSM = true;
 #elif __APPLE__
   // Mac sometimes adds them, e.g. Lucida Grande, Rockwell, Thonburi, Verdana
-  if(backupFontRenderer(tvkFontName))
+  if(fontDrawsCircles(tvkFontName))
     addSpaceNSM = false;
   else
     addSpaceNSM = true;
@@ -139,18 +186,42 @@ ThaiVirtualKeyboard::ThaiVirtualKeyboard(QWidget *parent) : QLabel(parent)
   // Get the size of the widget
   calculateTVKSize();
 
-  // Set the initial image
-  setPixmap(*thekeyboard);
+  // Zooming is measured in the background
+  measureZoom();
+}
+
+// Destructor
+ThaiVirtualKeyboard::~ThaiVirtualKeyboard()
+{
+  // Stop drawing in the background
+  renderThread->quit();
+  renderThread->wait();
+
+  // Shared keyboards are freed when the last keyboard holding them lets go
+  prepared.clear();
+
+  delete thekeyboard;
+  delete pressedkeyboard;
+  delete dictionary;
 }
 
 // Close the widget
 void ThaiVirtualKeyboard::closeEvent(QCloseEvent *e)
 {
   // Write font settings
+  {
+    TVKScopedTimer timing(TVKInstrumentation::Settings);
+
+    QSettings settings("lyndonhill.com", "TVK"); 
+    settings.setValue("font/name", tvkFontName);
+    settings.setValue("font/size", tvkFontSize);
+    settings.setValue("zoom/smallest", zoomSmallest);
+    settings.setValue("zoom/largest", zoomLargest);
+    settings.setValue("layout/name", currentLayout->name);
+  }
 
-  QSettings settings("lyndonhill.com", "TVK"); 
-  settings.setValue("font/name", tvkFontName);
-  settings.setValue("font/size", tvkFontSize);
+  // Nothing typed is lost
+  commitText();
 
   e->accept();
 }
@@ -159,128 +230,366 @@ void ThaiVirtualKeyboard::closeEvent(QCloseEvent *e)
 void ThaiVirtualKeyboard::mousePressEvent(QMouseEvent *e)
 {
   if(e->button() != Qt::LeftButton) return;
- 
-  QPixmap *currentkeyboard;
 
-  if(shifted == true)
-    currentkeyboard = shiftkeyboard;
-  else
-    currentkeyboard = thekeyboard;
+  pressAt(mousePress, e->position(), e->timestamp());
+}
 
-  int actual_width  = currentkeyboard->width();
-  int actual_height = currentkeyboard->height();
+// Press the key at a position. Every press is sent when it happens and keeps its own highlight,
+// so keys pressed together by two thumbs are all sent
+void ThaiVirtualKeyboard::pressAt(int id, const QPointF &position, quint64 timestamp)
+{
+  // Time until the highlight is painted
+  if(TVKInstrumentation::isEnabled())
+    pressClock.start();
 
-  float keywidth  = (float)(actual_width)/(float)(columns);
-  float keyheight = (float)(actual_height)/(float)(rows);
+  // Keys must match what is shown
+  if(resizing == true)
+    finishResize();
 
-  int tvk_code;
+  // A press without a release, e.g. the mouse was released outside the widget
+  int p = findPress(id);
+  if(p != -1)
+    updatePress(presses.takeAt(p));
 
-  // Get position of mouse
-  QPoint keypos = e->pos();
+  // Find the key under the point, keys are laid out on whole logical pixels below the suggestions
+  int k;
+  {
+    TVKScopedTimer timing(TVKInstrumentation::HitTest);
+    k = keyGeometry.keyAt(QPoint((int)floor(position.x()), (int)floor(position.y()) - keyboardTop()));
+  }
+
+  if(k == -1)
+    return;
 
-  int press_row, press_column;
+  const TVKKey &key = keyGeometry.key(k);
 
-  press_row = keypos.y() / keyheight;
-  if(press_row > 4) press_row = -1; // invalid row
+  TVKPress press;
+  press.id     = id;
+  press.row    = key.row;
+  press.column = key.column;
+  press.layer  = currentLayer;
+
+  presses.append(press);
+
+  // Key signal
 
-  press_column = -1; // invalid key
+  const TVKKeyDescriptor &d = currentKey(press.row, press.column);
 
-  switch(press_row)
+  if(d.sendsKey())
+    pressKey(d, press.layer, timestamp);
+
+  updatePress(press);
+}
+
+// Position of the mouse or a touch point in presses
+int ThaiVirtualKeyboard::findPress(int id) const
+{
+  for(int p = 0; p < presses.size(); p++)
   {
-    case 0:
-    press_column = keypos.x() / keywidth;
-    if(press_column >= 13)
-    {
-      press_column = 13; // delete
-      highlightArea.setCoords(1+press_column*keywidth, 1, currentkeyboard->width(), keyheight);
-    }
-    else
-      highlightArea.setCoords(1+press_column*keywidth, 1, (press_column+1)*keywidth, keyheight);
-    break;
-
-    case 1:
-    press_column = 0;
-    press_column += (keypos.x() - (int)(keywidth*0.5)) / keywidth;
-    if(press_column == 0)
-    {
-      // tab key
-      highlightArea.setCoords(1, keyheight, (int)(keywidth*1.5), keyheight*2);
-    }
-    else if(press_column >= 13)
-    {
-      press_column = 13; // enter
-      highlightArea.setCoords((int)(keywidth*13.5)+1, keyheight+1, currentkeyboard->width(), keyheight*2+1);
-    }
-    else
-      highlightArea.setCoords((int)(1+((press_column+0.5)*keywidth)), keyheight+1, (int)((press_column+1.5)*keywidth), keyheight*2);
-    break;
+    if(presses.at(p).id == id)
+      return(p);
+  }
 
-    case 2:
-    if(keypos.x() >= keywidth)
-    {
-      press_column = keypos.x() / keywidth;
-      if(press_column >= 13)
-      {
-        press_column = 13; // enter
-        highlightArea.setCoords((int)(keywidth*13.5)+1, keyheight+1, currentkeyboard->width(), keyheight*2+1);
-      }
-      else
-        highlightArea.setCoords(keywidth*press_column+1, keyheight*2+1, keywidth*(press_column+1)+1, keyheight*3);
-    }
-    else
+  return(-1);
+}
+
+// Send a key pressed on the keyboard, with the corrections of the sequence check
+void ThaiVirtualKeyboard::pressKey(const TVKKeyDescriptor &key, int layer, quint64 timestamp)
+{
+  int send[3];
+  int n = sequenceCheck.keysToSend(key.tis620, key.kind == TVKKeyDescriptor::Character, send);
+
+  for(int a = 0; a < n; a++)
+  {
+    TVKKeyDescriptor d = tvkDescribe(send[a]);
+    sendKey(d, layer, timestamp);
+    predict(d);
+  }
+
+  updateDimmed();
+}
+
+// Send a key press by KeyPressed, TextCommitted and the key queue
+void ThaiVirtualKeyboard::sendKey(const TVKKeyDescriptor &key, int layer, quint64 timestamp)
+{
+  emit KeyPressed(key.tis620);
+  emit UnicodeKeyPressed(tvkUnicodeView(key.tis620));
+
+  if(utf8Sink != NULL)
+    utf8Sink(tvkUtf8Text[key.tis620].bytes, tvkUtf8Text[key.tis620].length, utf8Context);
+
+  bufferKey(key);
+  queueKey(&key, NULL, layer, timestamp);
+
+  sequenceCheck.sent(key.tis620);
+}
+
+// Check the order of Thai characters before sending them
+void ThaiVirtualKeyboard::setSequenceCheck(TVKSequenceCheck::Mode mode, bool correct)
+{
+  sequenceCheck.setMode(mode, correct);
+  updateDimmed();
+}
+
+// Dim the keys the sequence check would reject now, only keys that change are repainted
+void ThaiVirtualKeyboard::updateDimmed()
+{
+  QRegion region;
+
+  if(sequenceCheck.mode() != TVKSequenceCheck::Off)
+  {
+    for(int k = 0; k < keyGeometry.count(); k++)
     {
-      press_column = 0;
-      highlightArea.setCoords(1, keyheight*2+1, keywidth-1, keyheight*3-1); // font
+      const TVKKey &key = keyGeometry.key(k);
+      const TVKKeyDescriptor &d = currentKey(key.row, key.column);
+
+      if((d.kind == TVKKeyDescriptor::Character) && (sequenceCheck.check(d.tis620) == TVKSequenceCheck::Reject))
+        region += key.area;
     }
-    break;
 
-    case 3:
-    if(keypos.x() < keywidth*14)
+    region.translate(0, keyboardTop());
+  }
+
+  if(region != dimmedRegion)
+  {
+    update(region.xored(dimmedRegion));
+    dimmedRegion = region;
+  }
+}
+
+// Collect key presses for TextCommitted
+void ThaiVirtualKeyboard::setCommitWindow(int ms)
+{
+  // Anything collected so far goes with the old window
+  if(!commitBuffer.isEmpty())
+    commitText();
+
+  commitWindow = (ms < 0) ? -1 : ms;
+}
+
+// Collect a key press, the window starts at the first key so text is never held for longer
+void ThaiVirtualKeyboard::bufferKey(const TVKKeyDescriptor &key)
+{
+  if(commitWindow < 0)
+    return;
+
+  // Control keys keep their ASCII code
+  commitBuffer += QChar(key.unicode);
+
+  if(!commitTimer->isActive())
+    commitTimer->start(commitWindow);
+}
+
+// Send the collected key presses
+void ThaiVirtualKeyboard::commitText()
+{
+  commitTimer->stop();
+
+  if(commitBuffer.isEmpty())
+    return;
+
+  QString text = commitBuffer;
+  commitBuffer.clear();
+
+  emit TextCommitted(text);
+}
+
+// Also send key presses to a queue drained on another thread
+void ThaiVirtualKeyboard::setKeyQueue(TVKKeyQueue *queue)
+{
+  keyQueue = queue;
+}
+
+// Also send key presses as UTF-8 to a function, for callers without Qt strings
+void ThaiVirtualKeyboard::setUtf8Sink(TVKUtf8Sink sink, void *context)
+{
+  utf8Sink    = sink;
+  utf8Context = context;
+}
+
+// Show a layout, its layers are drawn in the background so shift only swaps images
+bool ThaiVirtualKeyboard::setLayout(const QString &name)
+{
+  QSharedPointer<const TVKLayout> layout = TVKLayouts::find(name);
+  if(layout.isNull())
+    return(false);
+
+  currentLayout = layout;
+  currentLayer  = 0;
+  presses.clear();
+
+  // Switching back to a layout finds its layers drawn already
+  if(!keyboardReady() && !takePrepared())
+    drawKeyboard();
+
+  updateDimmed();
+
+  prepareAhead();
+  update();
+
+  return(true);
+}
+
+// Name of the layout shown
+QString ThaiVirtualKeyboard::layoutName() const
+{
+  return(currentLayout->name);
+}
+
+// Suggest words from a dictionary, the file is mapped so any size opens as quickly
+bool ThaiVirtualKeyboard::setDictionary(const QString &filename)
+{
+  predictionPrefix.clear();
+
+  if(filename.isEmpty())
+  {
+    delete dictionary;
+    delete predictionBar;
+    dictionary    = NULL;
+    predictionBar = NULL;
+
+    calculateTVKSize();
+    return(true);
+  }
+
+  TVKTrie *trie = new TVKTrie;
+  if(!trie->open(filename))
+  {
+    delete trie;
+    return(false);
+  }
+
+  delete dictionary;
+  dictionary = trie;
+
+  if(predictionBar == NULL)
+  {
+    predictionBar = new TVKPredictionBar(this);
+    predictionBar->setWordFont(tvkFontName, tvkFontSize);
+
+    connect(predictionBar, SIGNAL(suggestionChosen(int,quint64)), this, SLOT(chooseSuggestion(int,quint64)));
+
+    // Make room above the keys
+    calculateTVKSize();
+    predictionBar->setGeometry(0, 0, this->width(), keyboardTop());
+    predictionBar->show();
+  }
+
+  predictionBar->setSuggestions(QStringList());
+
+  return(true);
+}
+
+// Follow the word being typed and suggest how to finish it. Thai is written without spaces,
+// so a character that no word continues with starts the next word
+void ThaiVirtualKeyboard::predict(const TVKKeyDescriptor &key)
+{
+  if(dictionary == NULL)
+    return;
+
+  if(key.kind == TVKKeyDescriptor::Backspace)
+    predictionPrefix.chop(1);
+  else if((key.kind == TVKKeyDescriptor::Character) && (key.unicode >= 0x0e01) && (key.unicode <= 0x0e4e))
+    predictionPrefix += QChar(key.unicode);
+  else
+    predictionPrefix.clear();
+
+  QStringList words;
+
+  if(!predictionPrefix.isEmpty())
+  {
+    TVKScopedTimer timing(TVKInstrumentation::Predict);
+
+    // One more than shown, the word typed so far is not worth suggesting
+    QStringList found = dictionary->complete(predictionPrefix, TVKPredictionBar::cells+1);
+
+    if(found.isEmpty() && (predictionPrefix.size() > 1))
     {
-      press_column = 0;
-      press_column += (keypos.x() - (int)(keywidth*0.5)) / keywidth;
-      if(press_column == 0)
-      {
-        // left shift
-        highlightArea.setCoords(1, keyheight*3+1, (int)(1.5*keywidth), keyheight*4);
-      }
-      else if(press_column >= 12)
-      {
-        press_column = 12; // right shift
-        highlightArea.setCoords(1+(int)(12.5*keywidth), keyheight*3+1, 14*keywidth, keyheight*4);
-      }
-      else
-      {
-        highlightArea.setCoords((int)(1+((press_column+0.5)*keywidth)), keyheight*3+1, (int)((press_column+1.5)*keywidth), keyheight*4);
-      }
+      predictionPrefix = predictionPrefix.right(1);
+      found = dictionary->complete(predictionPrefix, TVKPredictionBar::cells+1);
     }
-    break;
 
-    case 4:
-    if((keypos.x() > keywidth*4) && (keypos.x() < keywidth*11))
+    for(int a = 0; a < found.size(); a++)
     {
-      press_column = 0;
-      highlightArea.setCoords(keywidth*4+1, keyheight*4+1, keywidth*11, keyheight*5-1); // space
+      if(found.at(a).size() > predictionPrefix.size())
+        words.append(found.at(a));
     }
-    break;
   }
 
-  keyrow = press_row;
-  keycol = press_column;
+  predictionBar->setSuggestions(words);
+}
 
-  // Key signal
+// Send the rest of a suggested word, as if each key was pressed
+void ThaiVirtualKeyboard::chooseSuggestion(int index, quint64 timestamp)
+{
+  const QStringList &words = predictionBar->suggestions();
+  if((index < 0) || (index >= words.size()))
+    return;
+
+  QString rest = words.at(index).mid(predictionPrefix.size());
+
+  for(int a = 0; a < rest.size(); a++)
+  {
+    int tis620 = tvkTIS620(rest.at(a).unicode());
+    if(tis620 == -1)
+      continue;
+
+    TVKKeyDescriptor d = tvkDescribe(tis620);
+    sendKey(d, currentLayer, timestamp);
+  }
+
+  // The word is finished
+  predictionPrefix.clear();
+  predictionBar->setSuggestions(QStringList());
+
+  updateDimmed();
+}
+
+// Key of the current layer at a keymap position
+const TVKKeyDescriptor &ThaiVirtualKeyboard::currentKey(int row, int column) const
+{
+  return(layerKey(currentLayer, row, column));
+}
 
-  if((press_row == -1) || (press_column == -1))
+// Key of a layer of the layout at a keymap position
+const TVKKeyDescriptor &ThaiVirtualKeyboard::layerKey(int layer, int row, int column) const
+{
+  return(currentLayout->layers.at(layer).key(row, column));
+}
+
+// Add a key press to the key queue, either a virtual key or a key passed through
+void ThaiVirtualKeyboard::queueKey(const TVKKeyDescriptor *key, QKeyEvent *e, int layer, quint64 timestamp)
+{
+  if(keyQueue == NULL)
     return;
 
-  tvk_code = shifted == false ? tvk_keymap[press_row*columns+press_column] :
-                               tvk_shifted_keymap[press_row*columns+press_column];
+  TVKKeyRecord record;
+  memset(&record, 0, sizeof(record));
 
-  if(tvk_code > 3)
-    emit KeyPressed(tvk_code);
+  record.layer     = layer;
+  record.timestamp = timestamp;
 
-  keydown = true;
-  update();
+  if(key != NULL)
+  {
+    record.source    = TVKKeyRecord::VirtualKey;
+    record.tis620    = key->tis620;
+    record.codepoint = key->unicode;
+  }
+  else
+  {
+    record.source           = TVKKeyRecord::PassThrough;
+    record.key              = e->key();
+    record.modifiers        = e->modifiers().toInt();
+    record.nativeScanCode   = e->nativeScanCode();
+    record.nativeVirtualKey = e->nativeVirtualKey();
+
+    QString text = e->text();
+    record.textLength = (text.size() < 4) ? text.size() : 4;
+    for(int a = 0; a < record.textLength; a++)
+      record.text[a] = text.at(a).unicode();
+  }
+
+  keyQueue->push(record);
 }
 
 // Where the key was released
@@ -288,479 +597,655 @@ void ThaiVirtualKeyboard::mouseReleaseEvent(QMouseEvent *e)
 {
   if(e->button() != Qt::LeftButton) return;
 
-  bool originalshift = shifted;
-  QPixmap *keyboard;
+  releasePress(mousePress);
+}
+
+// Release the key held by the mouse or a touch point
+void ThaiVirtualKeyboard::releasePress(int id)
+{
+  int originallayer = currentLayer;
+  bool fontchanged = false;
+
+  // Nothing was pressed, e.g. between keys or the press was cancelled, so the layer stays
+  int p = findPress(id);
+  if(p == -1)
+    return;
+
+  // The key is the one on the layer shown when it was pressed
+  TVKPress press = presses.takeAt(p);
+
+  QRegion dirty = pressedRegion(press);
+  TVKKeyDescriptor::Kind kind = layerKey(press.layer, press.row, press.column).kind;
 
   // Check if shift key was pressed - this way keyboard only changes
-  // when shift key is released.
-  if((keyrow == 3) && ((keycol == 0) || (keycol == 12)))
+  // when shift key is released. Shift steps through the layers of the layout
+
+  if(kind == TVKKeyDescriptor::Shift)
   {
-    shifted = !shifted;
+    currentLayer = (currentLayer + 1) % currentLayout->layers.size();
   }
-  else if((keyrow == 2) && (keycol == 0))
+  else if(kind == TVKKeyDescriptor::Font)
   {
     bool ok;
-#ifdef __APPLE__
-    QFont font = QFontDialog::getFont(&ok, QFont(tvkFontName, tvkFontSize), this, "Choose Keyboard Font", QFontDialog::DontUseNativeDialog);
-#else
-    QFont font = QFontDialog::getFont(&ok, QFont(tvkFontName, tvkFontSize), this, "Choose Keyboard Font");
-#endif
+    QFont font = TVKFontChooser::getFont(&ok, QFont(tvkFontName, tvkFontSize), this, "Choose Keyboard Font");
     if(ok)
     {
       tvkFontName = font.family();
       tvkFontSize = font.pointSize();
-      calculateTVKSize();
 
 #if __APPLE__
-      if(backupFontRenderer(tvkFontName))
+      if(fontDrawsCircles(tvkFontName))
         addSpaceNSM = false;
       else
         addSpaceNSM = true;
 #endif
 
-      drawKeyboard(true);
-      drawKeyboard(false);
+      refreshFont();
+
+      fontchanged = true;
     }
   }
+  else if(currentLayout->layers.at(currentLayer).latched == false)
+    currentLayer = 0;
+
+  if(originallayer != currentLayer)
+    showLayer();
+
+  // Changing keyboard needs a full repaint, otherwise just remove the highlight
+  if((originallayer != currentLayer) || fontchanged)
+    update();
   else
-    shifted = false;
+    update(dirty);
+}
 
-  keyboard = (shifted == true) ? shiftkeyboard : thekeyboard;
+// Everything needed to draw a layer at the current size and font
+TVKLayerSpec ThaiVirtualKeyboard::layerSpec(int layer) const
+{
+  TVKLayerSpec spec;
+
+  spec.size          = keyboardSize();
+  spec.ratio         = this->devicePixelRatioF();
+  spec.fontName      = tvkFontName;
+  spec.fontSize      = tvkFontSize;
+  spec.addSpaceNSM   = addSpaceNSM;
+  spec.layout        = currentLayout;
+  spec.layer         = layer;
+  spec.actionKeySize = actionKeySize;
+  spec.grayscale     = (memoryMode != FullColour);
+
+  return(spec);
+}
 
-  if(originalshift != shifted)
-  {
-    // Redraw keyboard if size changed since last time it was drawn
-    if((this->width() != keyboard->width()) || (this->height() != keyboard->height()))
-    {
-      *keyboard = keyboard->scaled(this->width()*keyboard->devicePixelRatio(), this->height()*keyboard->devicePixelRatio());
+// Draw the current layer now
+void ThaiVirtualKeyboard::drawKeyboard()
+{
+  TVKLayerSpec spec = layerSpec(currentLayer);
 
-      drawKeyboard(shifted);
-    }
-  }
+  // Keys are laid out for the size of the widget
+  keyGeometry.setSize(keyboardSize().width(), keyboardSize().height());
 
-  keydown = false;
-  update();
+  // Keep the glyphs for the worker thread too
+  glyphs = TVKGlyphAtlas::atlas(tvkFontName, tvkFontSize, spec.ratio, addSpaceNSM, TVKLayouts::keycaps(addSpaceNSM));
+
+  QImage pressed;
+  QImage keyboard = TVKLayerRenderer::render(spec, &pressed);
+
+  // Another keyboard may have drawn the same meanwhile, share that one
+  QSharedPointer<const TVKLayer> layer = TVKLayerCache::insert(spec, keyboard, pressed);
+
+  installKeyboard(spec, layer->keyboard, layer->pressed);
+  keepPrepared(layer);
 }
 
-// Draw the keyboard
-void ThaiVirtualKeyboard::drawKeyboard(bool shiftengage)
+// Draw a layer on the worker thread unless it is already up to date
+void ThaiVirtualKeyboard::prepareKeyboard(int layer)
 {
-  QPixmap *keyboard;
-  int *selectedkeymap;
+  if((layer == currentLayer) && keyboardReady())
+    return;
 
-  if(shiftengage == true)
-  {
-    keyboard = shiftkeyboard;
-    selectedkeymap = tvk_shifted_keymap;
-  }
-  else
+  TVKLayerSpec spec = layerSpec(layer);
+
+  // Zooming or another keyboard may have drawn it already
+  if(findPrepared(spec) != -1)
   {
-    keyboard = thekeyboard;
-    selectedkeymap = tvk_keymap;
+    if(layer == currentLayer)
+      takePrepared();
+    return;
   }
 
-  keyboard->fill();
- 
-  QPixmap *pix_backspace, *pix_tab, *pix_enter, *pix_shift, *pix_font;
- 
-  int a, b;
-  int tisvalue;
-  QChar keycap;
-  QString compoundcap;
+  glyphs = TVKGlyphAtlas::atlas(tvkFontName, tvkFontSize, spec.ratio, addSpaceNSM, TVKLayouts::keycaps(addSpaceNSM));
+
+  requestRender(spec, true);
+}
 
-  // Get size of standard key
+// Draw the other layers of the layout in the background, the next layer first as shift shows it
+void ThaiVirtualKeyboard::prepareLayers()
+{
+  int count = currentLayout->layers.size();
 
-  int actual_width  = keyboard->width();
-  int actual_height = keyboard->height();
+  for(int a = 1; a < count; a++)
+    prepareKeyboard((currentLayer + a) % count);
+}
 
-  float keywidth  = (float)(actual_width)/(float)(columns);
-  float keyheight = (float)(actual_height)/(float)(rows);
+// Draw the other layers and the next zoom levels in the background
+void ThaiVirtualKeyboard::prepareAhead()
+{
+  // Anything still waiting was for an old size
+  renderQueue.clear();
 
-  // select size of action keys
-  switch(actionKeySize)
+  if(!sizeLadder.isEmpty())
   {
-    case 0:
-    pix_backspace = pix_backspace_small;
-    pix_tab       = pix_tab_small;
-    pix_enter     = pix_enter_small;
-    pix_shift     = pix_shift_small;
-    pix_font      = pix_font_small;
-    break;
+    int step;
 
-    default:
-    case 1:
-    pix_backspace = pix_backspace_medium;
-    pix_tab       = pix_tab_medium;
-    pix_enter     = pix_enter_medium;
-    pix_shift     = pix_shift_medium;
-    pix_font      = pix_font_medium;
-    break;
+    // Every layer one size larger and one size smaller, as Ctrl+9 and Ctrl+8 will show them
+    for(step = 1; step >= -1; step -= 2)
+    {
+      int k = tvkFontSize + step - sizeLadder.first().fontSize;
+      if((k < 0) || (k >= sizeLadder.size()))
+        continue;
+
+      TVKLayerSpec spec  = layerSpec(currentLayer);
+      spec.fontSize      = sizeLadder.at(k).fontSize;
+      spec.size          = sizeLadder.at(k).minimumSize;
+      spec.actionKeySize = sizeLadder.at(k).actionKeySize;
 
-    case 2:
-    pix_backspace = pix_backspace_large;
-    pix_tab       = pix_tab_large;
-    pix_enter     = pix_enter_large;
-    pix_shift     = pix_shift_large;
-    pix_font      = pix_font_large;
-    break;
+      for(int a = 0; a < currentLayout->layers.size(); a++)
+      {
+        spec.layer = (currentLayer + a) % currentLayout->layers.size();
+        requestRender(spec, false);
+      }
+    }
   }
 
-  // Get size of keyboard image
-  int kbwidth  = actual_width;
-  int kbheight = actual_height;
+  // The other layers go first
+  prepareLayers();
+}
 
-  QPainter *mypaint = new QPainter();
-  mypaint->begin(keyboard);
-  mypaint->setPen(QColor(0,0,0));
-  mypaint->setFont(QFont(tvkFontName, tvkFontSize));
+// Show the current layer, normally it has been drawn and only the images are swapped
+void ThaiVirtualKeyboard::showLayer()
+{
+  if(!keyboardReady() && !takePrepared())
+    drawKeyboard();
 
-  // Draw outline
-  mypaint->drawLine(0, 0, kbwidth, 0);
-  mypaint->drawLine(0, 0, 0, kbheight);
-  mypaint->drawLine(0, kbheight, kbwidth, kbheight);
-  mypaint->drawLine(kbwidth, 0, kbwidth, kbheight);
+  updateDimmed();
 
-  // Draw rows
-  mypaint->drawLine(0, keyheight, kbwidth, keyheight);
-  mypaint->drawLine(0, keyheight*2, (int)(keywidth*13.5), keyheight*2);
-  mypaint->drawLine(0, keyheight*3, kbwidth, keyheight*3);
-  mypaint->drawLine(0, keyheight*4, keywidth*14, keyheight*4);
+  prepareLayers();
+}
 
-  // Draw columns
+// Ask the worker thread for a keyboard, urgent requests go first
+void ThaiVirtualKeyboard::requestRender(const TVKLayerSpec &spec, bool urgent)
+{
+  if(((renderPending == true) && (renderingSpec == spec)) || renderQueue.contains(spec) || (findPrepared(spec) != -1))
+    return;
 
-  for(a = 0; a < 14; a++)
-    mypaint->drawLine(a*keywidth, 0, a*keywidth, keyheight);
+  if(urgent == true)
+    renderQueue.prepend(spec);
+  else
+    renderQueue.append(spec);
 
-  for(a = 0; a < 13; a++)
-    mypaint->drawLine((int)((a+1.5)*keywidth), keyheight, (int)((a+1.5)*keywidth), keyheight*2);
+  nextRender();
+}
 
-  for(a = 0; a < 13; a++)
-    mypaint->drawLine((a+1)*keywidth, keyheight*2, (a+1)*keywidth, keyheight*3);
-  
-  for(a = 0; a < 12; a++)
-    mypaint->drawLine((int)((a+1.5)*keywidth), keyheight*3, (int)((a+1.5)*keywidth), keyheight*4);
+// Start the next request on the worker thread, one at a time
+void ThaiVirtualKeyboard::nextRender()
+{
+  if((renderPending == true) || renderQueue.isEmpty())
+    return;
 
-  mypaint->drawLine(keywidth*14, keyheight*3, keywidth*14, keyheight*4);
-  mypaint->drawLine(keywidth*4, keyheight*4, keywidth*4, kbheight);
-  mypaint->drawLine(keywidth*11, keyheight*4, keywidth*11, kbheight);
+  renderPending = true;
+  renderingSpec = renderQueue.takeFirst();
 
-  // Draw keycaps
+  QMetaObject::invokeMethod(renderer, "renderLayer", Qt::QueuedConnection, Q_ARG(TVKLayerSpec, renderingSpec));
+}
 
-  b = keyheight/2; // middle of first row
+// A keyboard was drawn on the worker thread
+void ThaiVirtualKeyboard::keyboardRendered(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed)
+{
+  renderPending = false;
 
-  QRect boundingbox;
+  QSharedPointer<const TVKLayer> layer = TVKLayerCache::insert(spec, keyboard, pressed);
 
-  for(a = 0; a < 13; a++)
+  // Show it if nothing changed while it was drawn
+  if(spec == layerSpec(currentLayer))
   {
-    // compoundcap.clear();
-    compoundcap = "";
+    installKeyboard(spec, layer->keyboard, layer->pressed);
+    update();
+  }
 
-    tisvalue = selectedkeymap[a];
-    if(addSpaceNSM)
-    {
-      if(tisvalue > 211 && tisvalue < 219) compoundcap = QChar(0x25cc);
-    }
+  keepPrepared(layer);
 
-    if(tisvalue > 127) tisvalue = tisvalue - 0xa0 + 0xe00; // convert to Unicode
-    keycap = QChar(tisvalue);
+  prepareLayers();
+  nextRender();
+}
 
-    compoundcap += keycap;
-    mypaint->drawText(QRect(keywidth*a, 0, keywidth, keyheight), Qt::AlignCenter, compoundcap);
-  }
+// Show a keyboard that has been drawn, the images are shared so nothing is copied
+void ThaiVirtualKeyboard::installKeyboard(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed)
+{
+  *thekeyboard = keyboard;
+  *pressedkeyboard = pressed;
+  keyboardSpec = spec;
 
-  b = (int)(keyheight*1.5); // middle of second row
+  // The keyboard shown before may be compressed now
+  compressPrepared();
+}
 
-  for(a = 1; a < 13; a++)
-  {
-    compoundcap = "";
+// The keyboard image matches the current layer, size and font
+bool ThaiVirtualKeyboard::keyboardReady() const
+{
+  return(layerSpec(currentLayer) == keyboardSpec);
+}
 
-    tisvalue = selectedkeymap[a+15];
+// Keep a keyboard that has been drawn
+void ThaiVirtualKeyboard::keepPrepared(const QSharedPointer<const TVKLayer> &layer)
+{
+  int k;
 
-    if(addSpaceNSM)
+  for(k = 0; k < prepared.size(); k++)
+  {
+    if(prepared.at(k)->spec == layer->spec)
     {
-#ifdef __linux
-      // Nasty hack for SARA AM (211). Should not need this ifdef but Linux font renderer always
-      // adds 0x25cc to SARA AM.
-      if(tisvalue == 209 || (tisvalue > 211 && tisvalue < 219) || (tisvalue == 234) || (tisvalue == 237)) compoundcap = QChar(0x25cc);
-#else
-      if(tisvalue == 209 || (tisvalue >= 211 && tisvalue < 219) || (tisvalue == 234) || (tisvalue == 237)) compoundcap = QChar(0x25cc);
-#endif
+      prepared.removeAt(k);
+      break;
     }
+  }
 
-    if(tisvalue > 127) tisvalue = tisvalue - 0xa0 + 0xe00; // convert to Unicode
-    keycap = QChar(tisvalue);
+  prepared.append(layer);
 
-    compoundcap += keycap;
-    mypaint->drawText(QRect(keywidth*(a+0.5), keyheight, keywidth, keyheight), Qt::AlignCenter, compoundcap);
+  // Let go of the least recently used at this ratio, keyboards for other screens are kept
+  int limit = preparedPerLayer*currentLayout->layers.size();
+  int count = 0;
+  for(k = prepared.size()-1; k >= 0; k--)
+  {
+    if(prepared.at(k)->spec.ratio != layer->spec.ratio)
+      continue;
+
+    if(++count > limit)
+      prepared.removeAt(k);
   }
 
-  b = (int)(keyheight*2.5); // middle of third row
+  compressPrepared();
+}
 
-  for(a = 1; a < 13; a++)
+// Position of a drawn keyboard, one drawn by another keyboard is kept too. -1 if it has not been drawn
+int ThaiVirtualKeyboard::findPrepared(const TVKLayerSpec &spec)
+{
+  for(int k = 0; k < prepared.size(); k++)
   {
-    compoundcap = "";
+    if(prepared.at(k)->spec == spec)
+      return(k);
+  }
+
+  QSharedPointer<const TVKLayer> shared = TVKLayerCache::find(spec);
+  if(shared.isNull())
+    return(-1);
 
-    tisvalue = selectedkeymap[a+30];
+  keepPrepared(shared);
 
-    if(addSpaceNSM)
+  return(prepared.size()-1);
+}
+
+// Show the current layer drawn earlier, false if it has not been drawn
+bool ThaiVirtualKeyboard::takePrepared()
+{
+  int k = findPrepared(layerSpec(currentLayer));
+  if(k == -1)
+    return(false);
+
+  // Most recently used goes last
+  prepared.move(k, prepared.size()-1);
+
+  // Keyboards that were not shown may be compressed
+  if(!prepared.last()->compressed.isEmpty())
+  {
+    QSharedPointer<const TVKLayer> expanded = TVKLayerCache::expand(*prepared.last());
+    if(expanded.isNull())
     {
-      if(tisvalue > 230 && tisvalue < 239) compoundcap = QChar(0x25cc);
+      prepared.removeLast();
+      return(false);
     }
 
-    if(tisvalue > 127) tisvalue = tisvalue - 0xa0 + 0xe00; // convert to Unicode
-    keycap = QChar(tisvalue);
-
-    compoundcap += keycap;
-    mypaint->drawText(QRect(keywidth*a, keyheight*2, keywidth, keyheight), Qt::AlignCenter, compoundcap);
+    prepared.last() = expanded;
   }
 
-  b = (int)(keyheight*3.5);
+  const TVKLayer &layer = *prepared.last();
+  installKeyboard(layer.spec, layer.keyboard, layer.pressed);
+
+  return(true);
+}
+
+// Compress the drawn keyboards that are not shown, the images are freed unless another
+// keyboard is holding them
+void ThaiVirtualKeyboard::compressPrepared()
+{
+  if(memoryMode != Compressed)
+    return;
 
-  for(a = 1; a < 12; a++)
+  for(int k = 0; k < prepared.size(); k++)
   {
-    compoundcap = "";
+    const TVKLayer &layer = *prepared.at(k);
 
-    tisvalue = selectedkeymap[a+45];
+    if(layer.compressed.isEmpty() && (layer.spec != keyboardSpec))
+      prepared[k] = TVKLayerCache::compress(layer);
+  }
+}
 
-    if(addSpaceNSM)
-    {
-      if((tisvalue > 211 && tisvalue < 219) || (tisvalue > 230 && tisvalue < 239)) compoundcap = QChar(0x25cc);
-    }
+// Keep drawn keyboards in less memory. Grey images are converted as they are painted, and
+// showing a compressed layer expands it first
+void ThaiVirtualKeyboard::setMemoryMode(MemoryMode mode)
+{
+  if(mode == memoryMode)
+    return;
 
-    if(tisvalue > 127) tisvalue = tisvalue - 0xa0 + 0xe00; // convert to Unicode
-    keycap = QChar(tisvalue);
+  memoryMode = mode;
 
-    compoundcap += keycap;
-    mypaint->drawText(QRect(keywidth*(a+0.5), keyheight*3, keywidth, keyheight), Qt::AlignCenter, compoundcap);
+  // Keyboards drawn in the other format are not needed
+  bool grayscale = (mode != FullColour);
+  for(int k = prepared.size()-1; k >= 0; k--)
+  {
+    if(prepared.at(k)->spec.grayscale != grayscale)
+      prepared.removeAt(k);
   }
 
-  // Draw action keys
-  mypaint->drawPixmap((int)(keywidth*14-(pix_backspace->width()/2)), (int)(keyheight*0.5-(pix_backspace->height()/2)), *pix_backspace);
-  mypaint->drawPixmap((int)(keywidth*0.75-(pix_tab->width()/2)), (int)(keyheight*1.5-(pix_tab->height()/2)), *pix_tab);
-  mypaint->drawPixmap((int)(keywidth*14.25-(pix_enter->width()/2)), (int)(keyheight*2-(pix_enter->height()/2)), *pix_enter);
-  mypaint->drawPixmap((int)(keywidth*0.5-(pix_font->width()/2)), (int)(keyheight*2.5-(pix_font->height()/2)), *pix_font);
+  compressPrepared();
 
-  // Fill in unused areas
-  int row5height = kbheight-1 - (int)(keyheight*4);
-  int spaceright = kbwidth-1 - (int)(keywidth*11);
-  int shiftright = kbwidth-1 - (int)(keywidth*14);
+  if(!keyboardReady() && !takePrepared())
+    drawKeyboard();
 
-  mypaint->fillRect(keywidth*14+1, keyheight*3+1, shiftright, keyheight+1, QColor(64,64,64));
-  mypaint->fillRect(1, keyheight*4+1, keywidth*4-1, row5height, QColor(64,64,64));
-  mypaint->fillRect(keywidth*11+1, keyheight*4+1, spaceright, row5height, QColor(64,64,64));
+  prepareAhead();
+  update();
+}
 
-  // Highlight shift keys
-  QPixmap hshift = *pix_shift;
-  QRgb pel;
+// Measure the zoom levels for the current font in the background
+void ThaiVirtualKeyboard::measureZoom()
+{
+  sizeLadder.clear();
+  ladderFontName = tvkFontName;
+  ladderNSM      = addSpaceNSM;
 
-  if(shiftengage == true)
-  {
-    QImage inverted = hshift.toImage();
+  QMetaObject::invokeMethod(renderer, "measureLadder", Qt::QueuedConnection, Q_ARG(QString, tvkFontName),
+                            Q_ARG(bool, addSpaceNSM), Q_ARG(int, zoomSmallest), Q_ARG(int, zoomLargest));
+}
 
-    for(b = 0; b < inverted.height(); b++)
-    {
-      for(a = 0; a < inverted.width(); a++)
-      {
-        pel = inverted.pixel(a, b);
+// Zoom levels were measured on the worker thread
+void ThaiVirtualKeyboard::ladderMeasured(const QString &fontName, bool nsm, const QList<TVKSizeStep> &ladder)
+{
+  // Ignore it if the font or range changed while it was measured
+  if((fontName != ladderFontName) || (nsm != ladderNSM) || ladder.isEmpty() ||
+     (ladder.first().fontSize != zoomSmallest) || (ladder.last().fontSize != zoomLargest))
+    return;
 
-        int inverse = qRed(pel);
-        inverted.setPixel(a, b, qRgb(255-inverse, 255-inverse, 255-inverse));
-      }
-    }
+  sizeLadder = ladder;
 
-    mypaint->fillRect(1, keyheight*3+1, keywidth*1.5, keyheight, QColor(0,0,0));
-    mypaint->fillRect(keywidth*12.5+1, keyheight*3+1, keywidth*1.5, keyheight, QColor(0,0,0));
+  prepareAhead();
+}
 
-    hshift = QPixmap::fromImage(inverted);
-  }
+// Font sizes that Ctrl+8 and Ctrl+9 are prepared for
+void ThaiVirtualKeyboard::setZoomRange(int smallest, int largest)
+{
+  if(smallest < 1) smallest = 1;
+  if(largest < smallest) largest = smallest;
 
-  mypaint->drawPixmap((int)(keywidth*0.75-(hshift.width()/2)), (int)(keyheight*3.5-(hshift.height()/2)), hshift);
-  mypaint->drawPixmap((int)(keywidth*13.25-(hshift.width()/2)), (int)(keyheight*3.5-(hshift.height()/2)), hshift);
+  zoomSmallest = smallest;
+  zoomLargest  = largest;
 
-  mypaint->end();
+  measureZoom();
+}
 
-/*
-  // TODO for Retina
-  if(highDPI)
+// Keyboard size for a font size, from the ladder when possible
+TVKSizeStep ThaiVirtualKeyboard::zoomStep(int fontSize) const
+{
+  if(!sizeLadder.isEmpty())
   {
-    thekeyboard->setDevicePixelRatio(2.0);
-    shiftkeyboard->setDevicePixelRatio(2.0);
+    int k = fontSize - sizeLadder.first().fontSize;
+    if((k >= 0) && (k < sizeLadder.size()))
+      return(sizeLadder.at(k));
   }
-*/
+
+  // Outside the range or not measured yet
+  return(TVKLayerRenderer::measure(tvkFontName, fontSize, addSpaceNSM));
 }
 
-// The keyboard was resized
+// The keyboard was resized, stretch the last image until the size settles
 void ThaiVirtualKeyboard::resizeEvent(QResizeEvent *)
 {
-  QPixmap *keyboard;
+  keyGeometry.setSize(keyboardSize().width(), keyboardSize().height());
 
-  if(shifted == true)
-    keyboard = shiftkeyboard;
-  else
-    keyboard = thekeyboard;
+  if(predictionBar != NULL)
+    predictionBar->setGeometry(0, 0, this->width(), keyboardTop());
 
-  *keyboard = keyboard->scaled(this->width()*keyboard->devicePixelRatio(), this->height()*keyboard->devicePixelRatio());
+  if(thekeyboard->isNull() || (findPrepared(layerSpec(currentLayer)) != -1))
+  {
+    // Nothing to stretch yet, or the keyboard is drawn already
+    finishResize();
+    return;
+  }
 
-  drawKeyboard(shifted);
+  if(resizing == false)
+  {
+    // Releasing the mouse also ends the resize
+    resizing = true;
+    qApp->installEventFilter(this);
+  }
 
+  resizeTimer->start(resizeQuietPeriod);
   update();
 }
 
-// Repaint the widget
-void ThaiVirtualKeyboard::paintEvent(QPaintEvent *p)
+// Draw the keyboard at its final size
+void ThaiVirtualKeyboard::finishResize()
 {
-  QRegion refreshregion = p->region();
-  QPainter qp(this);
+  resizeTimer->stop();
 
-  if(!refreshregion.isEmpty())
+  if(resizing == true)
   {
-    if(shifted == true)
-      qp.drawPixmap(0, 0, *shiftkeyboard);
-    else
-      qp.drawPixmap(0, 0, *thekeyboard);
+    resizing = false;
+    qApp->removeEventFilter(this);
   }
 
-  // Paint highlighted keys
-  int *selectedkeymap;
-  selectedkeymap = (shifted == true) ? tvk_shifted_keymap : tvk_keymap;
+  // Zooming normally finds the keyboard drawn already
+  if(!keyboardReady() && !takePrepared())
+    drawKeyboard();
 
-  QString compoundcap;
-  QChar keycap;
-
-  QImage inverted;
-  QPixmap action, *shift, *tab, *backspace, *enter, *font;
-  QRgb pel;
-  int px, py;
+  updateDimmed();
+  update();
 
-/*
-  int keywidth  = this->width()/columns;
-  int keyheight = this->height()/rows;
-*/
+  // Get the other layers ready
+  prepareAhead();
+}
 
-  if(actionKeySize == 2)
+// Follow touches, and watch for the device pixel ratio changing, e.g. when moved to another screen
+bool ThaiVirtualKeyboard::event(QEvent *e)
+{
+  // Touches are accepted so no mouse events are made from them
+  switch(e->type())
   {
-    backspace = pix_backspace_large;
-    tab       = pix_tab_large;
-    enter     = pix_enter_large;
-    shift     = pix_shift_large;
-    font      = pix_font_large;
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+      touchEvent(static_cast<QTouchEvent *>(e));
+      return(true);
+
+    case QEvent::TouchCancel:
+    {
+      // Nothing more is sent for keys still held by touch points, the mouse and physical keys
+      // are not touches
+      for(int p = presses.size()-1; p >= 0; p--)
+      {
+        if(presses.at(p).id >= 0)
+          updatePress(presses.takeAt(p));
+      }
+      return(true);
+    }
+
+    default:
+      break;
   }
-  else if(actionKeySize == 1)
+
+  bool result = QLabel::event(e);
+
+#if QT_VERSION >= 0x060600
+  if(e->type() == QEvent::DevicePixelRatioChange)
+#else
+  if(e->type() == QEvent::ScreenChangeInternal)
+#endif
   {
-    backspace = pix_backspace_medium;
-    tab       = pix_tab_medium;
-    enter     = pix_enter_medium;
-    shift     = pix_shift_medium;
-    font      = pix_font_medium;
+    // Keyboards drawn for this ratio before are used again
+    if(!thekeyboard->isNull())
+      finishResize();
   }
-  else
+
+  return(result);
+}
+
+// Press and release keys for every touch point that changed, each with the time of the event
+void ThaiVirtualKeyboard::touchEvent(QTouchEvent *e)
+{
+  const QList<QEventPoint> &points = e->points();
+
+  for(int a = 0; a < points.size(); a++)
   {
-    backspace = pix_backspace_small;
-    tab       = pix_tab_small;
-    enter     = pix_enter_small;
-    shift     = pix_shift_small;
-    font      = pix_font_small;
+    const QEventPoint &point = points.at(a);
+
+    if(point.state() == QEventPoint::Pressed)
+      pressAt(point.id(), point.position(), e->timestamp());
+    else if(point.state() == QEventPoint::Released)
+      releasePress(point.id());
   }
+}
 
-  px = 0; py = 0;
-  
-  if(keydown == true)
-  {
-    qp.fillRect(highlightArea, QColor(0,0,0));
+// Watch for the mouse being released during a resize
+bool ThaiVirtualKeyboard::eventFilter(QObject *o, QEvent *e)
+{
+  if((resizing == true) && (e->type() == QEvent::MouseButtonRelease))
+    resizeTimer->start(0);
 
-    compoundcap = "";
-    int tisvalue = selectedkeymap[keyrow*columns+keycol];
+  return(QLabel::eventFilter(o, e));
+}
 
-    if(tisvalue > 32)
-    {
-      qp.setPen(QColor(255,255,255));
-      qp.setFont(QFont(tvkFontName, tvkFontSize));
+// Redraw after the font has changed, the other keyboard is drawn in the background
+void ThaiVirtualKeyboard::refreshFont()
+{
+  // The ladder is measured for one font
+  if((tvkFontName != ladderFontName) || (addSpaceNSM != ladderNSM))
+    measureZoom();
 
-      if(tisvalue > 127)
-      {
-        if(addSpaceNSM)
-        {
-          if((tisvalue == 209) || ((tisvalue >= 211) && (tisvalue < 219)) || ((tisvalue > 230) && (tisvalue < 239)))
-          {
-            // Add space to NSM
-            compoundcap = QChar(0x25cc);
-          }
-        }
-
-        tisvalue = tisvalue - 0xa0 + 0xe00; // convert to Unicode
-      }
+  if(predictionBar != NULL)
+    predictionBar->setWordFont(tvkFontName, tvkFontSize);
 
-      keycap = QChar(tisvalue);
+  calculateTVKSize();
+  finishResize();
+}
 
-      compoundcap += keycap;
-      qp.drawText(highlightArea, Qt::AlignCenter, compoundcap);
-    }
-    else
-    {
-      // Draw action keys : get positioning of graphic
-      switch(tisvalue)
-      {
-        case 32: // space
-        break;   // do nothing - no graphic
-
-        case 1: // left shift
-        action = *shift;
-        px = highlightArea.x() + highlightArea.width()/2 - action.width()/2;
-        py = highlightArea.y() + highlightArea.height()/2 - action.height()/2;
-        break;
-
-        case 2: // right shift
-        action = *shift;
-        px = highlightArea.x() + highlightArea.width()/2 - action.width()/2;
-        py = highlightArea.y() + highlightArea.height()/2 - action.height()/2;
-        break;
-
-        case 3: // font selector
-        action = *font;
-        px = highlightArea.x() + highlightArea.width()/2 - action.width()/2;
-        py = highlightArea.y() + highlightArea.height()/2 - action.height()/2;
-        break;
-
-        case 8: // delete
-        action = *backspace;
-        px = highlightArea.x() + highlightArea.width()/2 - action.width()/2;
-        py = highlightArea.y() + highlightArea.height()/2 - action.height()/2;
-        break;
-
-        case 9: // tab
-        action = *tab;
-        px = highlightArea.x() + highlightArea.width()/2 - action.width()/2;
-        py = highlightArea.y() + highlightArea.height()/2 - action.height()/2;
-        break;
-
-        case 10: // enter
-        qp.fillRect((this->width()*(13.0/columns))+1, this->height()*(2.0/rows)+1, this->width(), this->height()/rows, QColor(0,0,0));
-        action = *enter;
-        px = highlightArea.x() + highlightArea.width()/2 - action.width()/2;
-        py = highlightArea.y() + highlightArea.height() - action.height()/2;
-        break;
-      }
+// Copy part of an image to the same place on the widget, the image starts top pixels down
+static void copyArea(QPainter &qp, const QRect &r, const QImage &from, int top)
+{
+  qreal ratio = from.devicePixelRatio();
 
-      if((tisvalue < 32) && (tisvalue > 0))
-      {
-        inverted = action.toImage();
+  // Ratios such as 1.25 do not put every logical pixel on a whole device pixel
+  qp.drawImage(QRectF(r), from, QRectF(r.x()*ratio, (r.y()-top)*ratio, r.width()*ratio, r.height()*ratio));
+}
 
-        int a, b;
-        for(b = 0; b < inverted.height(); b++)
-        {
-          for(a = 0; a < inverted.width(); a++)
-          {
-            pel = inverted.pixel(a, b);
+// Area of the widget covered by a pressed key, from the key geometry in case it was resized
+QRegion ThaiVirtualKeyboard::pressedRegion(const TVKPress &press) const
+{
+  int k = keyGeometry.find(press.row, press.column);
+  if(k == -1)
+    return(QRegion());
 
-            int inverse = qRed(pel);
-            inverted.setPixel(a, b, qRgb(255-inverse, 255-inverse, 255-inverse));
-          }
-        }
+  const TVKKey &key = keyGeometry.key(k);
+  QRegion region(key.area);
 
-        action = QPixmap::fromImage(inverted);
+  // Enter is two rows high, add the lower part
+  if(!key.lower.isEmpty())
+    region += key.lower;
 
-        qp.drawPixmap(px-1, py-1, action);
-      }
+  return(region.translated(0, keyboardTop()));
+}
+
+// Repaint a pressed key. Rectangles rather than a QRegion, so a press builds no region
+void ThaiVirtualKeyboard::updatePress(const TVKPress &press)
+{
+  int k = keyGeometry.find(press.row, press.column);
+  if(k == -1)
+    return;
+
+  const TVKKey &key = keyGeometry.key(k);
+  int top = keyboardTop();
+
+  update(key.area.translated(0, top));
+
+  // Enter is two rows high, repaint the lower part
+  if(!key.lower.isEmpty())
+    update(key.lower.translated(0, top));
+}
+
+// Area of the widget covered by every pressed key
+QRegion ThaiVirtualKeyboard::pressedRegion() const
+{
+  QRegion region;
+
+  for(int p = 0; p < presses.size(); p++)
+    region += pressedRegion(presses.at(p));
+
+  return(region);
+}
+
+// Top of the keys, below the suggestions
+int ThaiVirtualKeyboard::keyboardTop() const
+{
+  return((predictionBar == NULL) ? 0 : predictionBar->barHeight());
+}
+
+// Size of the keys, without the suggestions
+QSize ThaiVirtualKeyboard::keyboardSize() const
+{
+  return(QSize(this->width(), this->height() - keyboardTop()));
+}
+
+// Repaint the widget, only the damaged areas are copied
+void ThaiVirtualKeyboard::paintEvent(QPaintEvent *p)
+{
+  TVKScopedTimer timing(TVKInstrumentation::Paint);
+
+  // The suggestions paint themselves
+  int top = keyboardTop();
+  QRect keys(QPoint(0, top), keyboardSize());
+
+  QRegion refreshregion = p->region().intersected(keys);
+  QPainter qp(this);
+
+  QImage *keyboard = thekeyboard;
+  QImage *pressed  = pressedkeyboard;
+
+  if(resizing == true)
+  {
+    // Cheap preview while the size is changing
+    qp.drawImage(keys, *keyboard);
+    return;
+  }
+
+  QRegion::const_iterator it;
+
+  for(it = refreshregion.begin(); it != refreshregion.end(); ++it)
+    copyArea(qp, *it, *keyboard, top);
+
+  // Keys the sequence check would reject are faded
+  QRegion dimmed = dimmedRegion.intersected(refreshregion);
+  for(it = dimmed.begin(); it != dimmed.end(); ++it)
+    qp.fillRect(*it, QColor(255,255,255,160));
+
+  // Paint highlighted keys from the pressed sprites
+  if(!presses.isEmpty())
+  {
+    QRegion highlight = pressedRegion().intersected(refreshregion);
+
+    for(it = highlight.begin(); it != highlight.end(); ++it)
+      copyArea(qp, *it, *pressed, top);
+
+    if(pressClock.isValid() && !highlight.isEmpty())
+    {
+      TVKInstrumentation::record(TVKInstrumentation::PressToPaint, pressClock.nsecsElapsed());
+      pressClock.invalidate();
     }
   }
 
@@ -780,101 +1265,148 @@ void ThaiVirtualKeyboard::keyPressEvent(QKeyEvent *e)
     tvkFontSize = previousFontSize;
 
 #if __APPLE__
-  if(backupFontRenderer(tvkFontName))
+  if(fontDrawsCircles(tvkFontName))
     addSpaceNSM = false;
   else
     addSpaceNSM = true;
 #endif
 
-    calculateTVKSize();
+    refreshFont();
   }
   else if((e->key() == Qt::Key_9) && (e->modifiers() == Qt::ControlModifier))
   {
     tvkFontSize++;
-    calculateTVKSize();
+    refreshFont();
   }
   else if((e->key() == Qt::Key_8) && (e->modifiers() == Qt::ControlModifier))
   {
-    tvkFontSize--;
-    calculateTVKSize();
+    if(tvkFontSize > 1)
+    {
+      tvkFontSize--;
+      refreshFont();
+    }
   }
   else
+  {
+    // Keys typed on the keyboard are not passed through
+    if(physicalKeys && pressPhysicalKey(e))
+      return;
+
+    queueKey(NULL, e, currentLayer, e->timestamp());
     emit PassThroughkeyPressEvent(e);
+  }
 }
 
-// Calculate and set minimum size
-void ThaiVirtualKeyboard::calculateTVKSize()
+// Keymap index of the physical key of an event, -1 if the keyboard has no key there
+static int physicalKey(const QKeyEvent *e)
 {
-  int border = 2;
-  int glyph_width, glyph_height;
-  int min_width, min_height;
-  int khomut   = 0x0e5b;
-  int nine     = 0x0e59;
-  int ying     = 0x0e0d;
-  int jula     = 0x0e2c;
-  int am       = 0x0e33;
-  int maimalai = 0x0e44;
-
-  QChar testwide = QChar(khomut);
-  QString testhigh;
-
-  testhigh.append(QChar(0x0e44));
-  testhigh.append(QChar(0x0e1b));
-  testhigh.append(QChar(0x0e26));
-  testhigh.append(QChar(0x0e21));
-  testhigh.append(QChar(0x0e35));
-  testhigh.append(QChar(0x0e49));
-  testhigh.append(QChar(0x0e1a));
-  testhigh.append(QChar(0x0e39));
+#ifdef _WIN32
+  // Extended keys share the code of another key, e.g. keypad / is extended 0x35, the code of ฝ.
+  // Only keypad enter is typed, as enter. Qt sets bit 8 of an extended code, set 1 prefixes 0xe0
+  quint32 code = e->nativeScanCode();
+  if((code == 0x11c) || (code == 0xe01c))
+    code = 0x1c;
+  else if(code > 0xff)
+    return(-1);
+
+  return((code < 128) ? tvkSetOneKeys[code] : -1);
+#elif __APPLE__
+  quint32 code = e->nativeVirtualKey();
+  return((code < 128) ? tvkMacKeys[code] : -1);
+#else
+  // X11 and Wayland key codes are evdev codes plus 8
+  quint32 code = e->nativeScanCode() - 8;
+  return((code < 128) ? tvkSetOneKeys[code] : -1);
+#endif
+}
 
-  QFont f(tvkFontName, tvkFontSize);
-  QFontMetrics fm(f);
-  glyph_height = fm.boundingRect(testhigh).height();
+// Type the key at the position of a physical key, through the same path as a press on the
+// keyboard. The key is highlighted until the physical key is released
+bool ThaiVirtualKeyboard::pressPhysicalKey(QKeyEvent *e)
+{
+  // Shortcuts are passed through
+  if(e->modifiers() & ~(Qt::ShiftModifier | Qt::KeypadModifier))
+    return(false);
 
-  // Test several characters to find widest
-  QString testam;
-  if(addSpaceNSM)
-    testam.append(QChar(0x25cc));
-  testam.append(QChar(am));
+  int k = physicalKey(e);
+  if(k == -1)
+    return(false);
 
-  glyph_width  = fm.boundingRect(testwide).width();
+  int layer = 0;
+  if((e->modifiers() & Qt::ShiftModifier) && (currentLayout->layers.size() > 1))
+    layer = 1;
 
-  int test_glyph_width = fm.boundingRect(QChar(nine)).width();
-  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+  const TVKKeyDescriptor &d = layerKey(layer, k/columns, k%columns);
+  if(!d.sendsKey())
+    return(false);
 
-  test_glyph_width = fm.boundingRect(QChar(ying)).width();
-  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+  // Keys repeat while held, the highlight stays
+  if(findPress(physicalPress - k) == -1)
+  {
+    TVKPress press;
+    press.id     = physicalPress - k;
+    press.row    = k/columns;
+    press.column = k%columns;
+    press.layer  = layer;
+
+    presses.append(press);
+    updatePress(press);
+  }
 
-  test_glyph_width = fm.boundingRect(QChar(jula)).width();
-  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+  pressKey(d, layer, e->timestamp());
 
-  test_glyph_width = fm.boundingRect(testam).width();
-  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+  return(true);
+}
 
-  test_glyph_width = fm.boundingRect(QChar(maimalai)).width();
-  if(test_glyph_width > glyph_width) glyph_width = test_glyph_width;
+// End the flash of a physical key, repeats release the key only to press it again
+void ThaiVirtualKeyboard::keyReleaseEvent(QKeyEvent *e)
+{
+  int k = physicalKey(e);
+  int p = ((k == -1) || e->isAutoRepeat()) ? -1 : findPress(physicalPress - k);
 
-  if((glyph_width > 36) && (glyph_height > 36))
-  {
-    border = 8;
-    actionKeySize = 2;
-  }
-  else if((glyph_width > 20) && (glyph_height > 20))
+  if(p == -1)
   {
-    border = 4;
-    actionKeySize = 1;
+    QLabel::keyReleaseEvent(e);
+    return;
   }
-  else
+
+  update(pressedRegion(presses.takeAt(p)));
+}
+
+// Releases are not seen without focus, so the flash of every physical key ends
+void ThaiVirtualKeyboard::focusOutEvent(QFocusEvent *e)
+{
+  QRegion dirty;
+
+  for(int p = presses.size()-1; p >= 0; p--)
   {
-    border = 2;
-    actionKeySize = 0;
+    if(presses.at(p).id <= physicalPress)
+      dirty += pressedRegion(presses.takeAt(p));
   }
 
-  min_height = glyph_height*rows + border*rows*2;
-  min_width  = glyph_width*columns + border*columns*2;
+  update(dirty);
 
-  this->setMinimumSize(min_width, min_height);
-  this->resize(min_width, min_height);
+  QLabel::focusOutEvent(e);
+}
+
+// Type with a physical keyboard while the widget has focus
+void ThaiVirtualKeyboard::setPhysicalKeys(bool on)
+{
+  physicalKeys = on;
+}
+
+// Calculate and set minimum size, zooming finds it on the ladder
+void ThaiVirtualKeyboard::calculateTVKSize()
+{
+  TVKSizeStep step = zoomStep(tvkFontSize);
+
+  actionKeySize = step.actionKeySize;
+
+  // Suggestions go above the keys
+  QSize size = step.minimumSize + QSize(0, keyboardTop());
+
+  this->setMinimumSize(size);
+  this->resize(size);
 
   // Make sure TVK stays on screen!
   if((this->pos().x() < 0) || (this->pos().y() < 0))
@@ -884,8 +1416,13 @@ void ThaiVirtualKeyboard::calculateTVKSize()
 // Return true if font family doesn't support Thai
 bool ThaiVirtualKeyboard::backupFontRenderer(const QString &family) const
 {
-  QFontDatabase qdb;
-  QList<QFontDatabase::WritingSystem> sys = qdb.writingSystems(family);
+  TVKFontIndex *index = TVKFontIndex::instance();
+
+  if(index->isReady())
+    return(!index->find(family));
+
+  // Look it up until the index is ready
+  QList<QFontDatabase::WritingSystem> sys = QFontDatabase::writingSystems(family);
 
   QListIterator<QFontDatabase::WritingSystem> it(sys);
   while(it.hasNext())
@@ -901,3 +1438,14 @@ bool ThaiVirtualKeyboard::backupFontRenderer(const QString &family) const
   return(true);
 }
 
+// Return true if NSM are drawn on a dotted circle without adding one
+bool ThaiVirtualKeyboard::fontDrawsCircles(const QString &family) const
+{
+  TVKFontInfo info;
+
+  if(TVKFontIndex::instance()->find(family, &info))
+    return(info.drawsCircles);
+
+  // Fonts without Thai glyphs use a backup renderer, which adds them
+  return(backupFontRenderer(family));
+}
@@ -26,7 +26,31 @@
 #include <QWidget>
 #include <QLabel>
 #include <QPixmap>
+#include <QImage>
 #include <QRect>
+#include <QRegion>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QStringView>
+#include <QList>
+#include <QElapsedTimer>
+
+#include "TVKKeyGeometry.h"
+#include "TVKLayerRenderer.h"
+#include "TVKLayerCache.h"
+#include "TVKLayout.h"
+#include "TVKSequenceCheck.h"
+
+class QTimer;
+class QThread;
+class QTouchEvent;
+class TVKGlyphAtlas;
+class TVKKeyQueue;
+class TVKTrie;
+class TVKPredictionBar;
+
+/// Receives each key press as UTF-8, the bytes are static and not terminated
+typedef void (*TVKUtf8Sink)(const char *utf8, int length, void *context);
 
 /// @class Thai Virtual Keyboard (TVK)
 class ThaiVirtualKeyboard : public QLabel
@@ -37,13 +61,61 @@ public:
   /// Constructor
   ThaiVirtualKeyboard(QWidget *parent = NULL);
 
+  /// How drawn keyboards are kept
+  enum MemoryMode
+  {
+    FullColour,   ///< 32-bit images, the quickest to paint
+    Grayscale,    ///< 8-bit images, a quarter of the memory
+    Compressed    ///< 8-bit images, and only the layer shown is not compressed
+  };
+
   /// Destructor
-  ~ThaiVirtualKeyboard() { }
+  ~ThaiVirtualKeyboard();
+
+  /// Font sizes that Ctrl+8 and Ctrl+9 are prepared for
+  void setZoomRange(int smallest, int largest);
+
+  /// Collect key presses for TextCommitted: -1 = off, 0 = until the event loop is idle, otherwise ms
+  void setCommitWindow(int ms);
+
+  /// Also send key presses to a queue drained on another thread, NULL to stop. The queue is not owned
+  void setKeyQueue(TVKKeyQueue *queue);
+
+  /// Also send key presses as UTF-8 to a function, with context passed back. NULL to stop
+  void setUtf8Sink(TVKUtf8Sink sink, void *context = NULL);
+
+  /// Show a layout from TVKLayouts, false if there is no layout with that name
+  bool setLayout(const QString &name);
+
+  /// Name of the layout shown
+  QString layoutName() const;
+
+  /// Suggest words from a dictionary made by Dictionary/maketrie.py, an empty filename stops
+  /// suggesting. False if the dictionary cannot be opened
+  bool setDictionary(const QString &filename);
+
+  /// Check the order of Thai characters before sending them, keys that would be rejected are dimmed.
+  /// With correct, marks typed in the wrong order are reordered or replaced instead of rejected
+  void setSequenceCheck(TVKSequenceCheck::Mode mode, bool correct = true);
+
+  /// Keep drawn keyboards in less memory, at some cost in painting and switching layers
+  void setMemoryMode(MemoryMode mode);
+
+  /// Type with a physical keyboard while the widget has focus. Keys are found by scan code, so
+  /// each types the key at the same position on the layout, with shift for the second layer
+  void setPhysicalKeys(bool on);
 
 signals:
   /// Key press
   void KeyPressed(int tis620val);
 
+  /// Key press as Unicode, backspace, tab and enter are '\b', '\t' and '\n'. The view is of
+  /// static storage, so it stays valid and nothing is allocated
+  void UnicodeKeyPressed(QStringView text);
+
+  /// Key presses collected over the commit window, backspace, tab and enter are '\b', '\t' and '\n'
+  void TextCommitted(const QString &text);
+
   /// Key press to pass on to parent
   void PassThroughkeyPressEvent(QKeyEvent *e);
 
@@ -57,6 +129,12 @@ protected:
   /// Intercept hits to real keyboard
   void keyPressEvent(QKeyEvent *e);
 
+  /// End the flash of a physical key
+  void keyReleaseEvent(QKeyEvent *e);
+
+  /// End the flash of physical keys held when focus is lost
+  void focusOutEvent(QFocusEvent *e);
+
   /// Standard resize widget
   void resizeEvent(QResizeEvent *);
 
@@ -66,9 +144,139 @@ protected:
   /// Close the widget
   void closeEvent(QCloseEvent *);
 
+  /// Watch for the mouse being released during a resize
+  bool eventFilter(QObject *o, QEvent *e);
+
+  /// Follow touches and watch for the device pixel ratio changing
+  bool event(QEvent *e);
+
+private slots:
+  /// Draw the keyboard at its final size
+  void finishResize();
+
+  /// Send the collected key presses
+  void commitText();
+
+  /// A keyboard was drawn on the worker thread
+  void keyboardRendered(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed);
+
+  /// Zoom levels were measured on the worker thread
+  void ladderMeasured(const QString &fontName, bool addSpaceNSM, const QList<TVKSizeStep> &ladder);
+
+  /// Send the rest of a suggested word
+  void chooseSuggestion(int index, quint64 timestamp);
+
 private:
-  /// Draw the keyboard
-  void drawKeyboard(bool shift);
+  /// The benchmarks time private functions
+  friend class TVKBenchmark;
+
+  /// Traces save and restore the font and size
+  friend class TVKEventRecorder;
+
+  /// Everything needed to draw a layer at the current size and font
+  TVKLayerSpec layerSpec(int layer) const;
+
+  /// Draw the current layer now
+  void drawKeyboard();
+
+  /// Draw a layer on the worker thread unless it is already up to date
+  void prepareKeyboard(int layer);
+
+  /// Draw the other layers of the layout in the background
+  void prepareLayers();
+
+  /// Draw the other layers and the next zoom levels in the background
+  void prepareAhead();
+
+  /// Show the current layer, drawing it only if it has not been drawn
+  void showLayer();
+
+  /// Ask the worker thread for a keyboard, urgent requests go first
+  void requestRender(const TVKLayerSpec &spec, bool urgent);
+
+  /// Start the next request on the worker thread
+  void nextRender();
+
+  /// Show a keyboard that has been drawn
+  void installKeyboard(const TVKLayerSpec &spec, const QImage &keyboard, const QImage &pressed);
+
+  /// The keyboard image matches the current layer, size and font
+  bool keyboardReady() const;
+
+  /// Keep a keyboard that has been drawn in case it is needed again
+  void keepPrepared(const QSharedPointer<const TVKLayer> &layer);
+
+  /// Position of a drawn keyboard, -1 if it has not been drawn by this or any other keyboard
+  int findPrepared(const TVKLayerSpec &spec);
+
+  /// Show the current layer drawn earlier, false if it has not been drawn
+  bool takePrepared();
+
+  /// Compress the drawn keyboards that are not shown, in the compressed memory mode
+  void compressPrepared();
+
+  /// Key of the current layer at a keymap position
+  const TVKKeyDescriptor &currentKey(int row, int column) const;
+
+  /// Key of a layer of the layout at a keymap position
+  const TVKKeyDescriptor &layerKey(int layer, int row, int column) const;
+
+  /// Press the key at a position for the mouse or a touch point
+  void pressAt(int id, const QPointF &position, quint64 timestamp);
+
+  /// Release the key held by the mouse or a touch point
+  void releasePress(int id);
+
+  /// Position of the mouse or a touch point in presses, -1 if it holds no key
+  int findPress(int id) const;
+
+  /// Type the key at the position of a physical key, false if it is not typed
+  bool pressPhysicalKey(QKeyEvent *e);
+
+  /// Press and release keys for every touch point that changed
+  void touchEvent(QTouchEvent *e);
+
+  /// Measure the zoom levels for the current font in the background
+  void measureZoom();
+
+  /// Keyboard size for a font size, from the ladder when possible
+  TVKSizeStep zoomStep(int fontSize) const;
+
+  /// Redraw after the font has changed
+  void refreshFont();
+
+  /// Area of the widget covered by a pressed key
+  QRegion pressedRegion(const TVKPress &press) const;
+
+  /// Area of the widget covered by every pressed key
+  QRegion pressedRegion() const;
+
+  /// Repaint the area of a pressed key
+  void updatePress(const TVKPress &press);
+
+  /// Send a key pressed on a layer of the layout, after the sequence check
+  void pressKey(const TVKKeyDescriptor &key, int layer, quint64 timestamp);
+
+  /// Send a key press on a layer by KeyPressed, TextCommitted and the key queue
+  void sendKey(const TVKKeyDescriptor &key, int layer, quint64 timestamp);
+
+  /// Dim the keys the sequence check would reject now
+  void updateDimmed();
+
+  /// Collect a key press for TextCommitted
+  void bufferKey(const TVKKeyDescriptor &key);
+
+  /// Follow the word being typed and suggest how to finish it
+  void predict(const TVKKeyDescriptor &key);
+
+  /// Top of the keys, below the suggestions
+  int keyboardTop() const;
+
+  /// Size of the keys, without the suggestions
+  QSize keyboardSize() const;
+
+  /// Add a virtual key on a layer, or a key passed through, to the key queue
+  void queueKey(const TVKKeyDescriptor *key, QKeyEvent *e, int layer, quint64 timestamp);
 
   /// Calculate the minimum size of TVK, based on the current font size
   void calculateTVKSize();
@@ -76,35 +284,122 @@ private:
   /// Return true if font family doesn't support Thai
   bool backupFontRenderer(const QString &family) const;
 
+  /// Return true if the font family draws NSM on a dotted circle by itself
+  bool fontDrawsCircles(const QString &family) const;
+
   /// Width of widget, in keys
   int columns;
 
   /// Height of widget, in keys
   int rows;
 
-  /// Shift key active
-  bool shifted;
+  /// Layout shown
+  QSharedPointer<const TVKLayout> currentLayout;
+
+  /// Layer of the layout shown, shift steps through the layers
+  int currentLayer;
+
+  /// Keys held down, one for the mouse and each touch point
+  QList<TVKPress> presses;
+
+  /// The widget is being resized and shows a stretched image
+  bool resizing;
+
+  /// Delays drawing until resizing stops
+  QTimer *resizeTimer;
+
+  /// Time key presses are collected for, -1 if TextCommitted is off
+  int commitWindow;
+
+  /// Key presses not sent yet
+  QString commitBuffer;
+
+  /// Sends the collected key presses
+  QTimer *commitTimer;
+
+  /// Key presses for another thread, NULL if not used
+  TVKKeyQueue *keyQueue;
 
-  /// State of press down events
-  bool keydown;
+  /// Function taking key presses as UTF-8, NULL if not used
+  TVKUtf8Sink utf8Sink;
 
-  /// Key pressed row
-  int keyrow;
+  /// Passed back to utf8Sink
+  void *utf8Context;
 
-  /// Key pressed column
-  int keycol;
+  /// Words to suggest, NULL if not suggesting
+  TVKTrie *dictionary;
+
+  /// Suggested words, NULL if not suggesting
+  TVKPredictionBar *predictionBar;
+
+  /// Thai characters typed since the last word break
+  QString predictionPrefix;
+
+  /// Order of the characters sent
+  TVKSequenceCheck sequenceCheck;
+
+  /// Keys the sequence check would reject
+  QRegion dimmedRegion;
+
+  /// How drawn keyboards are kept
+  MemoryMode memoryMode;
+
+  /// Physical keys type the key at the same position
+  bool physicalKeys;
 
   /// Indicate which size action keys are in use: 0 = small, 1 = medium, 2 = large
   int actionKeySize;
 
-  /// Area of key to be highlighted
-  QRect highlightArea;
+  /// Started by a press when instrumentation is on, stopped when the highlight is painted
+  QElapsedTimer pressClock;
+
+  /// Position of the keys
+  TVKKeyGeometry keyGeometry;
+
+  /// Image of the current layer, switching layer swaps in an image from prepared
+  QImage *thekeyboard;
+
+  /// Pressed images of every key on the current layer
+  QImage *pressedkeyboard;
+
+  /// What the keyboard image was drawn with
+  TVKLayerSpec keyboardSpec;
+
+  /// Thread that draws keyboards in the background
+  QThread *renderThread;
 
-  /// Image of the keyboard
-  QPixmap *thekeyboard;
+  /// Draws keyboards, lives on renderThread
+  TVKLayerRenderer *renderer;
 
-  /// Image of the shift keyboard
-  QPixmap *shiftkeyboard;
+  /// Waiting for the worker thread
+  bool renderPending;
+
+  /// What the worker thread is drawing
+  TVKLayerSpec renderingSpec;
+
+  /// Keyboards waiting to be drawn
+  QList<TVKLayerSpec> renderQueue;
+
+  /// Recently used keyboards, shared with other keyboards, most recent last
+  QList<QSharedPointer<const TVKLayer> > prepared;
+
+  /// Keyboard size for every font size in the zoom range
+  QList<TVKSizeStep> sizeLadder;
+
+  /// Font the ladder is measured for
+  QString ladderFontName;
+
+  /// NSM setting the ladder is measured for
+  bool ladderNSM;
+
+  /// Smallest font size on the ladder
+  int zoomSmallest;
+
+  /// Largest font size on the ladder
+  int zoomLargest;
+
+  /// Rasterised keycaps for the current font
+  QSharedPointer<TVKGlyphAtlas> glyphs;
 
   /// Name of current font
   QString tvkFontName;
@@ -120,18 +415,8 @@ private:
   /// Previous font size
   int previousFontSize;
 
-  // Action keys
-  QPixmap *pix_backspace_large, *pix_backspace_medium, *pix_backspace_small;
-  QPixmap *pix_tab_large,   *pix_tab_medium,   *pix_tab_small;
-  QPixmap *pix_enter_large, *pix_enter_medium, *pix_enter_small;
-  QPixmap *pix_shift_large, *pix_shift_medium, *pix_shift_small;
-  QPixmap *pix_font_large,  *pix_font_medium,  *pix_font_small;
-
   /// Add a spacing character for NSM
   bool addSpaceNSM;
-
-  /// True if Retina
-  bool highDPI;
 };
 
 #endif  // ThaiVirtualKeyboard_h
@@ -0,0 +1,359 @@
+/**
+ * @file   tvkbench.cc
+ * @brief  Benchmarks for drawing, painting, sizing and hit-testing, without a display
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QImage>
+#include <QFont>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <math.h>
+
+#include "ThaiVirtualKeyboard.h"
+#include "TVKFontIndex.h"
+#include "TVKLayerRenderer.h"
+
+/// @class Runs each benchmark on a keyboard, a friend of ThaiVirtualKeyboard
+class TVKBenchmark
+{
+public:
+  /// Constructor
+  TVKBenchmark(int iterations, const QString &memory) : iterations(iterations), memory(memory) { }
+
+  /// Run every benchmark for one font
+  void run(const QString &font, const QList<int> &fontSizes, const QList<QSize> &sizes);
+
+  /// Everything measured so far
+  const QJsonArray &results() const { return(entries); }
+
+private:
+  /// Run the benchmarks for one size of keyboard
+  void runSize(ThaiVirtualKeyboard *kb, const QJsonObject &params);
+
+  /// Wait for the worker thread to measure the zoom levels
+  void waitForLadder(ThaiVirtualKeyboard *kb);
+
+  /// Add the latency distribution of an operation
+  void record(const QString &operation, QJsonObject params, QVector<qint64> &samples);
+
+  /// Times to run each operation
+  int iterations;
+
+  /// Memory mode: full, grayscale or compressed
+  QString memory;
+
+  /// Results
+  QJsonArray entries;
+};
+
+// Run every benchmark for one font
+void TVKBenchmark::run(const QString &font, const QList<int> &fontSizes, const QList<QSize> &sizes)
+{
+  ThaiVirtualKeyboard kb;
+  kb.show();
+
+  if(memory == "grayscale")
+    kb.setMemoryMode(ThaiVirtualKeyboard::Grayscale);
+  else if(memory == "compressed")
+    kb.setMemoryMode(ThaiVirtualKeyboard::Compressed);
+
+  for(int f = 0; f < fontSizes.size(); f++)
+  {
+    QElapsedTimer timer;
+    QVector<qint64> samples;
+    QJsonObject params;
+    int a;
+
+    kb.tvkFontName = font;
+    kb.tvkFontSize = fontSizes.at(f);
+    kb.refreshFont();
+
+    params["font"]     = font;
+    params["fontSize"] = fontSizes.at(f);
+    params["memory"]   = memory;
+
+    // Measuring a font from scratch, as calculateTVKSize did before the zoom ladder
+    for(a = 0; a < iterations; a++)
+    {
+      timer.start();
+      TVKLayerRenderer::measure(font, fontSizes.at(f), kb.addSpaceNSM);
+      samples.append(timer.nsecsElapsed());
+    }
+    record("measure", params, samples);
+
+    // Zooming, the size comes from the ladder and the keyboards from the cache
+    waitForLadder(&kb);
+    for(a = 0; a < iterations; a++)
+    {
+      timer.start();
+      kb.calculateTVKSize();
+      kb.finishResize();
+      samples.append(timer.nsecsElapsed());
+    }
+    record("calculateTVKSize", params, samples);
+
+    for(int s = 0; s < sizes.size(); s++)
+    {
+      kb.resize(sizes.at(s));
+      kb.finishResize();
+
+      // The minimum size for the font may have made it larger than asked
+      params["width"]  = kb.width();
+      params["height"] = kb.height();
+
+      runSize(&kb, params);
+    }
+  }
+}
+
+// Run the benchmarks for one size of keyboard, on every layer of the layout
+void TVKBenchmark::runSize(ThaiVirtualKeyboard *kb, const QJsonObject &sizeparams)
+{
+  QElapsedTimer timer;
+  QVector<qint64> samples;
+  int layer, a;
+
+  for(layer = 0; layer < kb->currentLayout->layers.size(); layer++)
+  {
+    QJsonObject params = sizeparams;
+    params["layout"] = kb->currentLayout->name;
+    params["layer"]  = kb->currentLayout->layers.at(layer).name;
+
+    kb->currentLayer = layer;
+    kb->finishResize();
+
+    for(a = 0; a < iterations; a++)
+    {
+      timer.start();
+      kb->drawKeyboard();
+      samples.append(timer.nsecsElapsed());
+    }
+    record("drawKeyboard", params, samples);
+
+    // Switching to this layer from the one before, as shift does. Compressed layers are expanded
+    int count = kb->currentLayout->layers.size();
+    for(a = 0; a < iterations; a++)
+    {
+      kb->currentLayer = (layer + count - 1) % count;
+      kb->showLayer();
+
+      timer.start();
+      kb->currentLayer = layer;
+      kb->showLayer();
+      samples.append(timer.nsecsElapsed());
+    }
+    record("showLayer", params, samples);
+
+    // Painting goes through paintEvent
+    QImage target(kb->size()*kb->devicePixelRatioF(), QImage::Format_RGB32);
+    target.setDevicePixelRatio(kb->devicePixelRatioF());
+
+    for(a = 0; a < iterations; a++)
+    {
+      timer.start();
+      kb->render(&target);
+      samples.append(timer.nsecsElapsed());
+    }
+    record("paintEvent/full", params, samples);
+
+    // One key, as after a press or release
+    QRegion key(kb->keyGeometry.key(kb->keyGeometry.find(1, 5)).area);
+    for(a = 0; a < iterations; a++)
+    {
+      timer.start();
+      kb->render(&target, key.boundingRect().topLeft(), key);
+      samples.append(timer.nsecsElapsed());
+    }
+    record("paintEvent/key", params, samples);
+
+    // Hit-testing alone is too quick to time once, so time a sweep of the keyboard
+    int width  = kb->width();
+    int height = kb->height();
+    int points = 1000;
+    volatile int found = 0;
+
+    for(a = 0; a < iterations; a++)
+    {
+      timer.start();
+      for(int p = 0; p < points; p++)
+        found += kb->keyGeometry.keyAt(QPoint((p*7919) % width, (p*104729) % height));
+      samples.append(timer.nsecsElapsed()/points);
+    }
+    record("keyAt", params, samples);
+
+    // Press and release a character key, shift and font would change the keyboard
+    QPointF centre(kb->keyGeometry.key(kb->keyGeometry.find(1, 5)).centre);
+    for(a = 0; a < iterations; a++)
+    {
+      QMouseEvent press(QEvent::MouseButtonPress, centre, kb->mapToGlobal(centre),
+                        Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+      QMouseEvent release(QEvent::MouseButtonRelease, centre, kb->mapToGlobal(centre),
+                          Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+
+      timer.start();
+      kb->mousePressEvent(&press);
+      kb->mouseReleaseEvent(&release);
+      samples.append(timer.nsecsElapsed());
+    }
+    record("mousePressEvent+mouseReleaseEvent", params, samples);
+  }
+
+  kb->currentLayer = 0;
+  kb->finishResize();
+}
+
+// Wait for the worker thread to measure the zoom levels
+void TVKBenchmark::waitForLadder(ThaiVirtualKeyboard *kb)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  while(kb->sizeLadder.isEmpty() && (timer.elapsed() < 10000))
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+
+// Add the latency distribution of an operation, samples are cleared for the next one
+void TVKBenchmark::record(const QString &operation, QJsonObject params, QVector<qint64> &samples)
+{
+  if(samples.isEmpty())
+    return;
+
+  std::sort(samples.begin(), samples.end());
+
+  qint64 total = 0;
+  for(int a = 0; a < samples.size(); a++)
+    total += samples.at(a);
+
+  int n = samples.size();
+
+  params["operation"] = operation;
+  params["samples"]   = n;
+  params["min_ns"]    = samples.first();
+  params["mean_ns"]   = (double)total/n;
+  params["p50_ns"]    = samples.at(qBound(0, (int)ceil(0.50*n)-1, n-1));
+  params["p90_ns"]    = samples.at(qBound(0, (int)ceil(0.90*n)-1, n-1));
+  params["p99_ns"]    = samples.at(qBound(0, (int)ceil(0.99*n)-1, n-1));
+  params["max_ns"]    = samples.last();
+
+  entries.append(params);
+  samples.clear();
+}
+
+// Read a list of numbers
+static QList<int> numbers(const QString &text)
+{
+  QList<int> list;
+  QStringList parts = text.split(',', Qt::SkipEmptyParts);
+
+  for(int a = 0; a < parts.size(); a++)
+    list.append(parts.at(a).toInt());
+
+  return(list);
+}
+
+// Read a list of sizes such as 420x160
+static QList<QSize> sizes(const QString &text)
+{
+  QList<QSize> list;
+  QStringList parts = text.split(',', Qt::SkipEmptyParts);
+
+  for(int a = 0; a < parts.size(); a++)
+  {
+    QStringList wh = parts.at(a).split('x');
+    if(wh.size() == 2)
+      list.append(QSize(wh.at(0).toInt(), wh.at(1).toInt()));
+  }
+
+  return(list);
+}
+
+int main(int argc, char **argv)
+{
+  // No display is needed
+  if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication a(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Thai Virtual Keyboard benchmarks, results are written as JSON");
+  parser.addHelpOption();
+  parser.addOption(QCommandLineOption("iterations", "Times to run each operation.", "n", "50"));
+  parser.addOption(QCommandLineOption("fonts", "Number of Thai fonts to use, 0 for all.", "n", "3"));
+  parser.addOption(QCommandLineOption("font", "Use this font, may be repeated.", "family"));
+  parser.addOption(QCommandLineOption("font-sizes", "Font sizes.", "list", "12,24,48"));
+  parser.addOption(QCommandLineOption("sizes", "Keyboard sizes.", "list", "420x160,840x320,1680x640"));
+  parser.addOption(QCommandLineOption("memory", "Memory mode: full, grayscale or compressed.", "mode", "full"));
+  parser.addOption(QCommandLineOption("output", "Write results to a file instead of stdout.", "file"));
+  parser.process(a);
+
+  QStringList fonts = parser.values("font");
+  if(fonts.isEmpty())
+  {
+    // Wait for the Thai fonts to be found
+    TVKFontIndex::instance()->wait();
+    fonts = TVKFontIndex::instance()->families();
+
+    int count = parser.value("fonts").toInt();
+    if((count > 0) && (fonts.size() > count))
+      fonts = fonts.mid(0, count);
+
+    if(fonts.isEmpty())
+      fonts.append(QFont().family());
+  }
+
+  TVKBenchmark benchmark(qMax(1, parser.value("iterations").toInt()), parser.value("memory"));
+
+  for(int f = 0; f < fonts.size(); f++)
+    benchmark.run(fonts.at(f), numbers(parser.value("font-sizes")), sizes(parser.value("sizes")));
+
+  QJsonObject report;
+  report["qt"]         = qVersion();
+  report["platform"]   = QGuiApplication::platformName();
+  report["iterations"] = parser.value("iterations").toInt();
+  report["results"]    = benchmark.results();
+
+  QByteArray json = QJsonDocument(report).toJson();
+
+  if(parser.isSet("output"))
+  {
+    QFile file(parser.value("output"));
+    if(!file.open(QIODevice::WriteOnly))
+    {
+      QTextStream(stderr) << "Cannot write " << parser.value("output") << "\n";
+      return(1);
+    }
+    file.write(json);
+  }
+  else
+    QTextStream(stdout) << json;
+
+  return(0);
+}
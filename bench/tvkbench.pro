@@ -0,0 +1,59 @@
+# Copyright (C) 2026 Lyndon Hill
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Benchmarks, runs without a display on the offscreen platform
+
+TEMPLATE     = app
+CONFIG      += qt release c++17 console
+CONFIG      -= app_bundle
+TARGET       = tvkbench
+INCLUDEPATH += ..
+
+QT          += widgets
+
+# Input
+
+HEADERS     += ../ThaiVirtualKeyboard.h \
+               ../TVKEventRecorder.h \
+               ../TVKFontChooser.h \
+               ../TVKFontIndex.h \
+               ../TVKGlyphAtlas.h \
+               ../TVKInstrumentation.h \
+               ../TVKKeyGeometry.h \
+               ../TVKKeyQueue.h \
+               ../TVKKeyTable.h \
+               ../TVKLayerCache.h \
+               ../TVKLayerRenderer.h \
+               ../TVKLayout.h \
+               ../TVKPredictionBar.h \
+               ../TVKScanCodes.h \
+               ../TVKSequenceCheck.h \
+               ../TVKTrie.h
+
+SOURCES     += tvkbench.cc \
+               ../ThaiVirtualKeyboard.cc \
+               ../TVKEventRecorder.cc \
+               ../TVKFontChooser.cc \
+               ../TVKFontIndex.cc \
+               ../TVKGlyphAtlas.cc \
+               ../TVKInstrumentation.cc \
+               ../TVKKeyGeometry.cc \
+               ../TVKKeyQueue.cc \
+               ../TVKLayerCache.cc \
+               ../TVKLayerRenderer.cc \
+               ../TVKLayout.cc \
+               ../TVKPredictionBar.cc \
+               ../TVKSequenceCheck.cc \
+               ../TVKTrie.cc
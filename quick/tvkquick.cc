@@ -0,0 +1,70 @@
+/**
+ * @file   tvkquick.cc
+ * @brief  Shows the Qt Quick keyboard in a QML window, with the software backend if asked
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QQuickView>
+#include <QQuickWindow>
+#include <QQmlEngine>
+#include <QSGRendererInterface>
+#include <QTextStream>
+#include <QUrl>
+
+#include "TVKQuickKeyboard.h"
+
+int main(int argc, char **argv)
+{
+  QGuiApplication a(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Shows Thai Virtual Keyboard as a Qt Quick item, with the text typed above it.");
+  parser.addHelpOption();
+  parser.addOption(QCommandLineOption("software", "Draw with the Qt Quick software backend, no GPU is needed."));
+  parser.addOption(QCommandLineOption("layout", "Layout to show.", "name", "Kedmanee"));
+  parser.process(a);
+
+  // Must be chosen before the window is made
+  if(parser.isSet("software"))
+    QQuickWindow::setGraphicsApi(QSGRendererInterface::Software);
+
+  qmlRegisterType<TVKQuickKeyboard>("TVK", 1, 0, "ThaiVirtualKeyboard");
+
+  QQuickView view;
+  view.setResizeMode(QQuickView::SizeRootObjectToView);
+  view.setSource(QUrl("qrc:/tvkquick.qml"));
+
+  if(view.status() == QQuickView::Error)
+    return(1);
+
+  // The layout can be set from QML too
+  TVKQuickKeyboard *keyboard = view.rootObject()->findChild<TVKQuickKeyboard *>();
+  if((keyboard != NULL) && !keyboard->setLayout(parser.value("layout")))
+  {
+    QTextStream(stderr) << "No layout named " << parser.value("layout") << "\n";
+    return(1);
+  }
+
+  view.setTitle("Thai Virtual Keyboard");
+  view.show();
+
+  return(a.exec());
+}
@@ -0,0 +1,49 @@
+# Copyright (C) 2026 Lyndon Hill
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+# Thai Virtual Keyboard as a Qt Quick item, in a QML window
+
+TEMPLATE     = app
+CONFIG      += qt release c++17
+TARGET       = tvkquick
+INCLUDEPATH += ..
+
+QT          += quick
+
+# Input
+
+HEADERS     += ../TVKQuickKeyboard.h \
+               ../TVKFontIndex.h \
+               ../TVKGlyphAtlas.h \
+               ../TVKInstrumentation.h \
+               ../TVKKeyGeometry.h \
+               ../TVKKeyTable.h \
+               ../TVKLayerCache.h \
+               ../TVKLayerRenderer.h \
+               ../TVKLayout.h \
+               ../TVKSequenceCheck.h
+
+SOURCES     += tvkquick.cc \
+               ../TVKQuickKeyboard.cc \
+               ../TVKFontIndex.cc \
+               ../TVKGlyphAtlas.cc \
+               ../TVKInstrumentation.cc \
+               ../TVKKeyGeometry.cc \
+               ../TVKLayerCache.cc \
+               ../TVKLayerRenderer.cc \
+               ../TVKLayout.cc \
+               ../TVKSequenceCheck.cc
+
+RESOURCES   += tvkquick.qrc
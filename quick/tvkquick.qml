@@ -0,0 +1,48 @@
+// Copyright (C) 2026 Lyndon Hill
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+import QtQuick
+import TVK 1.0
+
+// Text typed on the keyboard, above the keyboard
+
+Rectangle {
+  width: keyboard.implicitWidth
+  height: keyboard.implicitHeight + 48
+  color: "white"
+
+  Text {
+    id: typed
+    anchors { left: parent.left; right: parent.right; top: parent.top; margins: 8 }
+    height: 32
+    font.pixelSize: 24
+    elide: Text.ElideLeft
+  }
+
+  ThaiVirtualKeyboard {
+    id: keyboard
+    anchors { left: parent.left; right: parent.right; top: typed.bottom; bottom: parent.bottom; topMargin: 8 }
+
+    // Backspace takes back the last character and enter clears the text
+    onTextPressed: function(text) {
+      if(text == "\b")
+        typed.text = typed.text.slice(0, -1)
+      else if(text == "\n")
+        typed.text = ""
+      else
+        typed.text += text
+    }
+  }
+}
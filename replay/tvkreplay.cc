@@ -0,0 +1,314 @@
+/**
+ * @file   tvkreplay.cc
+ * @brief  Replays recorded input events into a keyboard without a display, and makes traces from text
+ * @author Lyndon Hill
+ * @date   2026.10.17
+ *
+    Copyright (C) 2026 Lyndon Hill
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QKeyEvent>
+#include <QTouchEvent>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QTest>
+
+#include <algorithm>
+#include <math.h>
+
+#include "ThaiVirtualKeyboard.h"
+#include "TVKEventRecorder.h"
+
+// Time for the other layers and zoom levels to be drawn in the background before replaying, ms
+static const int settleTime = 500;
+
+// Sample at a percentile of sorted samples
+static qint64 percentile(const QVector<qint64> &sorted, double p)
+{
+  int n = sorted.size();
+
+  return(sorted.at(qBound(0, (int)ceil(p*n)-1, n-1)));
+}
+
+// Deliver one recorded event to the keyboard. Touches go through the window system as real
+// ones do, so each touch point has its position in the widget
+static void deliver(ThaiVirtualKeyboard *kb, const TVKTraceEvent &event, QPointingDevice *touchscreen,
+                    QTest::QTouchEventWidgetSequence &touches)
+{
+  switch(event.type)
+  {
+    case TVKTraceEvent::MousePress:
+    case TVKTraceEvent::MouseRelease:
+    {
+      bool press = (event.type == TVKTraceEvent::MousePress);
+      QMouseEvent m(press ? QEvent::MouseButtonPress : QEvent::MouseButtonRelease, event.position,
+                    kb->mapToGlobal(event.position), Qt::LeftButton, press ? Qt::LeftButton : Qt::NoButton,
+                    Qt::NoModifier);
+      m.setTimestamp(event.time/1000);
+      QCoreApplication::sendEvent(kb, &m);
+      break;
+    }
+
+    case TVKTraceEvent::TouchPress:
+    touches.press(event.id, event.position.toPoint(), kb);
+    touches.commit();
+    break;
+
+    case TVKTraceEvent::TouchRelease:
+    touches.release(event.id, event.position.toPoint(), kb);
+    touches.commit();
+    break;
+
+    case TVKTraceEvent::TouchCancel:
+    {
+      QTouchEvent cancel(QEvent::TouchCancel, touchscreen);
+      QCoreApplication::sendEvent(kb, &cancel);
+      break;
+    }
+
+    case TVKTraceEvent::KeyPress:
+    case TVKTraceEvent::KeyRelease:
+    {
+      QKeyEvent k((event.type == TVKTraceEvent::KeyPress) ? QEvent::KeyPress : QEvent::KeyRelease, event.key,
+                  Qt::KeyboardModifiers::fromInt(event.modifiers), event.scanCode, event.virtualKey, 0, event.text);
+      k.setTimestamp(event.time/1000);
+      QCoreApplication::sendEvent(kb, &k);
+      break;
+    }
+
+    case TVKTraceEvent::Resize:
+    kb->resize((int)event.position.x(), (int)event.position.y());
+    break;
+
+    // Chosen as the row of suggestions would, the recording does not say where it was tapped
+    case TVKTraceEvent::Suggestion:
+    QMetaObject::invokeMethod(kb, "chooseSuggestion", Qt::DirectConnection, Q_ARG(int, event.id),
+                              Q_ARG(quint64, event.time/1000));
+    break;
+
+    default:
+    break;
+  }
+}
+
+// Replay a trace, as fast as possible or at the recorded times. The latency of an event runs
+// until it has been handled and painted. Key presses emitted are checked against the recording
+static QJsonObject replay(const TVKEventTrace &trace, bool realtime, bool *matched)
+{
+  QJsonObject report;
+  *matched = false;
+
+  ThaiVirtualKeyboard kb;
+  kb.show();
+
+  QString error;
+  if(!TVKEventRecorder::restore(&kb, trace.setup, &error))
+  {
+    report["error"] = error;
+    return(report);
+  }
+
+  QTest::qWait(settleTime);
+
+  // The key presses emitted are recorded to check them
+  TVKEventRecorder output;
+  output.start(&kb);
+
+  QPointingDevice *touchscreen = QTest::createTouchDevice();
+  QTest::QTouchEventWidgetSequence touches = QTest::touchEvent(&kb, touchscreen, false);
+
+  QVector<qint64> latency;
+  QElapsedTimer clock, timer;
+  clock.start();
+
+  for(int a = 0; a < trace.events.size(); a++)
+  {
+    const TVKTraceEvent &event = trace.events.at(a);
+
+    if(event.type == TVKTraceEvent::Emitted)
+      continue;
+
+    if(realtime)
+    {
+      qint64 wait = (qint64)event.time - clock.nsecsElapsed()/1000;
+      if(wait > 0)
+        QThread::usleep(wait);
+    }
+
+    timer.start();
+    deliver(&kb, event, touchscreen, touches);
+    QCoreApplication::processEvents();
+    latency.append(timer.nsecsElapsed());
+  }
+
+  qint64 elapsed = clock.nsecsElapsed();
+  output.stop();
+
+  // First difference between the key presses recorded and those emitted now
+  QList<int> expected = trace.emitted();
+  QList<int> emitted  = output.trace().emitted();
+
+  int mismatch = -1;
+  for(int a = 0; a < qMax(expected.size(), emitted.size()); a++)
+  {
+    if((a >= expected.size()) || (a >= emitted.size()) || (expected.at(a) != emitted.at(a)))
+    {
+      mismatch = a;
+      break;
+    }
+  }
+
+  *matched = (mismatch == -1);
+
+  report["realtime"]       = realtime;
+  report["events"]         = latency.size();
+  report["expected"]       = expected.size();
+  report["emitted"]        = emitted.size();
+  report["matched"]        = *matched;
+  report["first_mismatch"] = mismatch;
+  report["elapsed_ns"]     = elapsed;
+
+  if(!latency.isEmpty())
+  {
+    std::sort(latency.begin(), latency.end());
+
+    qint64 total = 0;
+    for(int a = 0; a < latency.size(); a++)
+      total += latency.at(a);
+
+    report["events_per_s"] = (elapsed > 0) ? latency.size()*1e9/elapsed : 0.0;
+    report["min_ns"]       = latency.first();
+    report["mean_ns"]      = (double)total/latency.size();
+    report["p50_ns"]       = percentile(latency, 0.50);
+    report["p90_ns"]       = percentile(latency, 0.90);
+    report["p99_ns"]       = percentile(latency, 0.99);
+    report["max_ns"]       = latency.last();
+  }
+
+  return(report);
+}
+
+int main(int argc, char **argv)
+{
+  // No display is needed
+  if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication a(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Replays a trace recorded from Thai Virtual Keyboard, the report is written as JSON.\n"
+                                   "With --generate, makes a trace that types a UTF-8 text file instead.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("trace", "Trace file to replay, or to write with --generate.");
+  parser.addOption(QCommandLineOption("realtime", "Replay at the recorded times rather than as fast as possible."));
+  parser.addOption(QCommandLineOption("output", "Write the report to a file instead of stdout.", "file"));
+  parser.addOption(QCommandLineOption("generate", "Make a trace that types this text.", "text-file"));
+  parser.addOption(QCommandLineOption("layout", "Layout to type on.", "name", "Kedmanee"));
+  parser.addOption(QCommandLineOption("font", "Font of the keyboard.", "family", "Arial"));
+  parser.addOption(QCommandLineOption("font-size", "Font size of the keyboard.", "n", "24"));
+  parser.addOption(QCommandLineOption("size", "Size of the keyboard.", "size", "840x320"));
+  parser.addOption(QCommandLineOption("interval", "Time from one press to the next, ms.", "ms", "150"));
+  parser.addOption(QCommandLineOption("hold", "Time each key is held, ms.", "ms", "60"));
+  parser.process(a);
+
+  if(parser.positionalArguments().size() != 1)
+    parser.showHelp(1);
+
+  QString filename = parser.positionalArguments().first();
+  QString error;
+
+  if(parser.isSet("generate"))
+  {
+    QFile text(parser.value("generate"));
+    if(!text.open(QIODevice::ReadOnly))
+    {
+      QTextStream(stderr) << "Cannot read " << parser.value("generate") << "\n";
+      return(1);
+    }
+
+    QStringList wh = parser.value("size").split('x');
+
+    TVKEventTrace trace;
+    trace.setup.size     = (wh.size() == 2) ? QSize(wh.at(0).toInt(), wh.at(1).toInt()) : QSize(840, 320);
+    trace.setup.layout   = parser.value("layout");
+    trace.setup.fontName = parser.value("font");
+    trace.setup.fontSize = parser.value("font-size").toInt();
+
+    // The font may make the keyboard larger than asked, lay the taps out at the size it will be
+    ThaiVirtualKeyboard kb;
+    TVKEventRecorder::restore(&kb, trace.setup);
+    trace.setup.size = kb.size();
+
+    if(!trace.fromText(QString::fromUtf8(text.readAll()), parser.value("interval").toInt(),
+                       parser.value("hold").toInt(), &error))
+    {
+      QTextStream(stderr) << error << "\n";
+      return(1);
+    }
+
+    if(!trace.save(filename))
+    {
+      QTextStream(stderr) << "Cannot write " << filename << "\n";
+      return(1);
+    }
+
+    QTextStream(stdout) << trace.events.size() << " events, " << trace.emitted().size() << " key presses\n";
+    return(0);
+  }
+
+  TVKEventTrace trace;
+  if(!trace.load(filename, &error))
+  {
+    QTextStream(stderr) << filename << ": " << error << "\n";
+    return(1);
+  }
+
+  bool matched;
+  QJsonObject report = replay(trace, parser.isSet("realtime"), &matched);
+  report["trace"]    = filename;
+  report["qt"]       = qVersion();
+  report["platform"] = QGuiApplication::platformName();
+
+  QByteArray json = QJsonDocument(report).toJson();
+
+  if(parser.isSet("output"))
+  {
+    QFile file(parser.value("output"));
+    if(!file.open(QIODevice::WriteOnly))
+    {
+      QTextStream(stderr) << "Cannot write " << parser.value("output") << "\n";
+      return(1);
+    }
+    file.write(json);
+  }
+  else
+    QTextStream(stdout) << json;
+
+  // Scripts can stop on a replay that emitted different key presses
+  if(report.contains("error"))
+    return(1);
+
+  return(matched ? 0 : 2);
+}
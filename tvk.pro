@@ -14,7 +14,7 @@
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 TEMPLATE     = app
-CONFIG      += qt release
+CONFIG      += qt release c++17
 TARGET       = virtualkb
 INCLUDEPATH += .
 
@@ -22,8 +22,36 @@ QT          += widgets
 
 # Input
 
-HEADERS     += ThaiVirtualKeyboard.h
+HEADERS     += ThaiVirtualKeyboard.h \
+               TVKEventRecorder.h \
+               TVKFontChooser.h \
+               TVKFontIndex.h \
+               TVKGlyphAtlas.h \
+               TVKInstrumentation.h \
+               TVKKeyGeometry.h \
+               TVKKeyQueue.h \
+               TVKKeyTable.h \
+               TVKLayerCache.h \
+               TVKLayerRenderer.h \
+               TVKLayout.h \
+               TVKPredictionBar.h \
+               TVKScanCodes.h \
+               TVKSequenceCheck.h \
+               TVKTrie.h
 
 SOURCES     += virtualkb.cc \
-               ThaiVirtualKeyboard.cc
+               ThaiVirtualKeyboard.cc \
+               TVKEventRecorder.cc \
+               TVKFontChooser.cc \
+               TVKFontIndex.cc \
+               TVKGlyphAtlas.cc \
+               TVKInstrumentation.cc \
+               TVKKeyGeometry.cc \
+               TVKKeyQueue.cc \
+               TVKLayerCache.cc \
+               TVKLayerRenderer.cc \
+               TVKLayout.cc \
+               TVKPredictionBar.cc \
+               TVKSequenceCheck.cc \
+               TVKTrie.cc
 
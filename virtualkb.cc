@@ -21,8 +21,10 @@
  */
 
 #include <QApplication>
+#include <QTextStream>
 
 #include "ThaiVirtualKeyboard.h"
+#include "TVKEventRecorder.h"
 
 int main(int argc, char **argv)
 {
@@ -30,8 +32,28 @@ int main(int argc, char **argv)
 
   ThaiVirtualKeyboard *mykb = new ThaiVirtualKeyboard;
   mykb->resize(420,160);
+
+  // The dictionary is beside the program unless TVK_DICTIONARY says where it is
+  QString dictionary = qEnvironmentVariable("TVK_DICTIONARY");
+  if(dictionary.isEmpty())
+    dictionary = QCoreApplication::applicationDirPath() + "/Dictionary/thai.trie";
+
+  if(!mykb->setDictionary(dictionary))
+    QTextStream(stderr) << "Cannot open dictionary " << dictionary << ", words are not suggested\n";
+
   mykb->show();
 
-  return(a.exec());
+  // Record the session for replay/tvkreplay if TVK_RECORD_FILE is set
+  TVKEventRecorder recorder;
+  QString recordfile = qEnvironmentVariable("TVK_RECORD_FILE");
+  if(!recordfile.isEmpty())
+    recorder.start(mykb);
+
+  int result = a.exec();
+
+  if(!recordfile.isEmpty())
+    recorder.trace().save(recordfile);
+
+  return(result);
 }
 